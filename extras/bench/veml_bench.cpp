@@ -0,0 +1,71 @@
+/**
+ * @brief	Benchmark of autorange convergence of readAW() on simulated VEML7700.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	For grid of light (0.01 lux .. 120 klux) and start gain & time, it run readAW()
+ * 			and print number of ranging steps, latency (virtual ms), i2c transactions
+ * 			and relative error of lux. Each ranging policy has own table and summary.
+ * 			Build and run on Linux from root of library:
+ * 			g++ -std=c++11 -O2 -I. -Iextras/host mkigor_veml*.cpp extras/host/veml_sim.cpp \
+ * 				extras/bench/veml_bench.cpp -o veml_bench && ./veml_bench
+ */
+
+#include <veml_sim.h>
+#include <mkigor_veml_range.h>
+
+static const float gv_lux[] = { 0.01, 0.1, 1.0, 10.0, 100.0, 1000.0, 10000.0, 50000.0, 120000.0 };
+static const GTidx_stru_t gv_start[] = { {0, 0}, {0, 2}, {2, 2}, {3, 5} };
+static const uint16_t gv_startMs[] = { 25, 100, 100, 800 };		///	integration time of gv_start
+static cl_VEMLrangeStep		gv_step;
+static cl_VEMLrangePredict		gv_predict;
+static cl_VEMLrangeLatency		gv_latency(250);
+static cl_VEMLrangeMaxRes		gv_maxRes;
+static cl_VEMLrange *gv_policy[] = { &gv_step, &gv_predict, &gv_latency, &gv_maxRes };
+static const char *gv_policyName[] = { "step", "predict", "latency 250 ms", "max resolution" };
+
+int main() {
+	const uint8_t lv_nLux = sizeof(gv_lux) / sizeof(gv_lux[0]);
+	const uint8_t lv_nStart = sizeof(gv_start) / sizeof(gv_start[0]);
+
+	for (uint8_t m = 0; m < sizeof(gv_policy) / sizeof(gv_policy[0]); m++) {
+		uint32_t lv_sumMs = 0, lv_maxMs = 0, lv_sumSteps = 0, lv_maxSteps = 0, lv_sumTrans = 0;
+		float lv_maxErr = 0;
+
+		printf("\n%s\n", gv_policyName[m]);
+		printf("%10s %6s %6s %8s %6s %10s %8s\n", "lux", "start", "steps", "ms", "i2c", "result", "err,%");
+		for (uint8_t i = 0; i < lv_nLux; i++) {
+			for (uint8_t j = 0; j < lv_nStart; j++) {
+				cl_VEMLsim lv_sim;
+				cl_VEML7700 lv_veml(lv_sim);
+				simSetMillis(0);
+				lv_sim.setLux(gv_lux[i]);
+				lv_veml.check();
+				lv_veml.setRangePolicy(*gv_policy[m]);
+				lv_veml.writeGainTime(gv_start[j].idxGain1, gv_start[j].idxTime1);
+				delay(gv_startMs[j] + 10);			///	first counts with start gain & time are ready
+
+				lv_sim.resetStats();
+				uint32_t lv_t0 = millis();
+				AW_stru_t lv_AW = lv_veml.readAW();
+				uint32_t lv_ms = millis() - lv_t0;
+				uint32_t lv_steps = lv_veml.steps();
+				float lv_err = fabs((float)lv_AW.als1 - gv_lux[i]) / gv_lux[i] * 100.0;
+
+				printf("%10.2f %3d,%-2d %6u %8u %6u %10u %8.2f\n", gv_lux[i],
+					gv_start[j].idxGain1, gv_start[j].idxTime1, lv_steps, lv_ms,
+					lv_sim.transactions(), lv_AW.als1, lv_err);
+
+				lv_sumMs += lv_ms;
+				lv_sumSteps += lv_steps;
+				lv_sumTrans += lv_sim.transactions();
+				if (lv_ms > lv_maxMs) lv_maxMs = lv_ms;
+				if (lv_steps > lv_maxSteps) lv_maxSteps = lv_steps;
+				if ((gv_lux[i] >= 1.0) && (lv_err > lv_maxErr)) lv_maxErr = lv_err;
+			}
+		}
+		uint32_t lv_n = lv_nLux * lv_nStart;
+		printf("summary %s: steps avg %.2f max %u, ms avg %.1f max %u, i2c avg %.1f, max err (>= 1 lux) %.2f%%\n",
+			gv_policyName[m], (float)lv_sumSteps / lv_n, lv_maxSteps, (float)lv_sumMs / lv_n, lv_maxMs,
+			(float)lv_sumTrans / lv_n, lv_maxErr);
+	}
+	return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * @brief	Benchmark of coroutine API (mkigor_veml_coro.h) on simulated VEML7700.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	Several sensors with different light are measured by one task each, tasks are run
+ * 			by cl_VEMLsched::run() on virtual clock. Light is changed x30 between rounds, so each
+ * 			round need ranging. Result of each sensor is checked, and total time is compared
+ * 			with readAW() of the same sensors one by one.
+ * 			Build and run on Linux from root of library:
+ * 			g++ -std=c++20 -O2 -I. -Iextras/host mkigor_veml*.cpp extras/host/veml_sim.cpp \
+ * 				extras/bench/veml_coro_bench.cpp -o veml_coro_bench && ./veml_coro_bench
+ */
+
+#include <veml_sim.h>
+#include <mkigor_veml_coro.h>
+
+static const uint8_t gv_nSensors = 4;
+static const uint8_t gv_nRounds = 5;
+static const float gv_lux[gv_nSensors] = { 0.5, 40.0, 1500.0, 90000.0 };
+
+static cl_VEMLsim gv_sim[gv_nSensors];
+static cl_VEML7700 gv_veml[gv_nSensors] = { gv_sim[0], gv_sim[1], gv_sim[2], gv_sim[3] };
+static uint32_t gv_errors = 0;
+static uint32_t gv_done[gv_nSensors] = {};
+static const uint16_t gv_settleMs = 900;		///	light is settled on sensor after change
+
+/// light of sensor in round, odd rounds are 30 times brighter
+static float roundLux(uint8_t lp_idx, uint8_t lp_round) {
+	float lv_lux = gv_lux[lp_idx] * ((lp_round & 1) ? 30.0f : 1.0f);
+	return (lv_lux > 120000.0f) ? 120000.0f : lv_lux;
+}
+
+static void setRound(uint8_t lp_idx, uint8_t lp_round) { gv_sim[lp_idx].setLux(roundLux(lp_idx, lp_round)); }
+
+/// measure sensor gv_nRounds times, light is changed x30 between rounds, so ranging has work
+static cl_VEMLtask<void> job(uint8_t lp_idx) {
+	for (uint8_t r = 0; r < gv_nRounds; r++) {
+		AW_stru_t lv_AW = co_await vemlMeasure(gv_veml[lp_idx]);
+		uint32_t lv_expect = (uint32_t)(roundLux(lp_idx, r) + 0.5f);
+		uint32_t lv_diff = (lv_AW.als1 > lv_expect) ? lv_AW.als1 - lv_expect : lv_expect - lv_AW.als1;
+		if (lv_diff > 1 + lv_expect / 1000) gv_errors++;
+		gv_done[lp_idx]++;
+		setRound(lp_idx, r + 1);
+		co_await vemlSleepUntil(millis() + gv_settleMs);
+	}
+}
+
+/// start all sensors from the least sensitive gain & time, so ranging has work
+static void init() {
+	simSetMillis(0);
+	for (uint8_t i = 0; i < gv_nSensors; i++) {
+		gv_sim[i].setLux(gv_lux[i]);
+		gv_veml[i].check();
+		gv_veml[i].writeGainTime(0, 0);
+		gv_sim[i].resetStats();
+	}
+	delay(100);
+}
+
+int main() {
+	init();
+	uint32_t lv_t0 = millis();
+	for (uint8_t r = 0; r < gv_nRounds; r++) {
+		for (uint8_t i = 0; i < gv_nSensors; i++) {
+			gv_veml[i].readAW();
+			setRound(i, r + 1);
+		}
+		delay(gv_settleMs);
+	}
+	uint32_t lv_seqMs = millis() - lv_t0;
+
+	init();
+	cl_VEMLsched lv_sched;
+	for (uint8_t i = 0; i < gv_nSensors; i++) lv_sched.spawn(job(i));
+	lv_t0 = millis();
+	lv_sched.run();
+	uint32_t lv_coroMs = millis() - lv_t0;
+
+	bool lv_ok = (gv_errors == 0);
+	for (uint8_t i = 0; i < gv_nSensors; i++) {
+		printf("sensor %u: lux %10.1f, rounds %u, i2c %u\n", i, gv_lux[i], gv_done[i], gv_sim[i].transactions());
+		if (gv_done[i] != gv_nRounds) lv_ok = false;
+	}
+	printf("%u sensors x %u rounds: readAW() one by one %u ms, coroutines %u ms, errors %u -> %s\n",
+		gv_nSensors, gv_nRounds, lv_seqMs, lv_coroMs, gv_errors, lv_ok ? "OK" : "FAIL");
+	return lv_ok ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+/**
+ * @brief	Stress test of lock-free sample queue (mkigor_veml_queue.h) with std::thread.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	Producer thread push numbered samples as fast as it can, consumer thread pop them
+ * 			and check order and content. Every sample must be received or counted in overruns().
+ * 			Drop pass push bursts of 1.5 capacity and yield, so at least 10 % must be received,
+ * 			retry pass wait for free slot and lose nothing.
+ * 			Then cl_VEMLacq measure simulated VEML7700 in paced producer thread, live consumer
+ * 			must receive almost all samples (>= 99 %). At the end one
+ * 			thread publish latest sample (cl_VEMLlatest), other threads read and check it.
+ * 			Build and run on Linux from root of library (-fsanitize=thread is welcome):
+ * 			g++ -std=c++11 -O2 -pthread -I. -Iextras/host mkigor_veml*.cpp extras/host/veml_sim.cpp \
+ * 				extras/bench/veml_queue_stress.cpp -o veml_queue_stress && ./veml_queue_stress
+ */
+
+#include <thread>
+#include <chrono>
+#include <veml_sim.h>
+#include <mkigor_veml_queue.h>
+
+static const uint32_t gv_nSamples = 5000000;
+
+/// numbered sample, each field is function of number, so torn sample is seen
+static VEMLsample_stru_t makeSample(uint32_t lp_n) {
+	VEMLsample_stru_t lv_s;
+	lv_s.ms = lp_n;
+	lv_s.raw.gt = { (uint8_t)(lp_n & 3), (uint8_t)(lp_n % 6) };
+	lv_s.raw.als = (uint16_t)lp_n;
+	lv_s.raw.whi = (uint16_t)~lp_n;
+	lv_s.aw = { lp_n * 3, lp_n ^ 0xA5A5A5A5 };
+	return lv_s;
+}
+
+static bool sameSample(const VEMLsample_stru_t &lp_a, const VEMLsample_stru_t &lp_b) {
+	return (lp_a.ms == lp_b.ms) && (lp_a.raw.gt.idxGain1 == lp_b.raw.gt.idxGain1)
+		&& (lp_a.raw.gt.idxTime1 == lp_b.raw.gt.idxTime1) && (lp_a.raw.als == lp_b.raw.als)
+		&& (lp_a.raw.whi == lp_b.raw.whi) && (lp_a.aw.als1 == lp_b.aw.als1) && (lp_a.aw.whi1 == lp_b.aw.whi1);
+}
+
+int main() {
+	int lv_fail = 0;
+
+	///	1. numbered samples, producer and consumer at full speed,
+	///	pass 0 - producer drop sample if queue is full, pass 1 - producer retry, nothing is lost
+	for (uint8_t lv_pass = 0; lv_pass < 2; lv_pass++) {
+		cl_VEMLqueue<64> lv_queue;
+		bool lv_done = false;
+		uint32_t lv_received = 0, lv_errors = 0;
+
+		std::thread lv_consumer([&]() {
+			VEMLsample_stru_t lv_s;
+			uint32_t lv_last = 0;
+			bool lv_first = true;
+			for (;;) {
+				bool lv_end = __atomic_load_n(&lv_done, __ATOMIC_ACQUIRE);	///	before pop: all pushes are seen
+				if (!lv_queue.pop(lv_s)) {
+					if (lv_end) break;
+					std::this_thread::yield();
+					continue;
+				}
+				if (!sameSample(lv_s, makeSample(lv_s.ms))) lv_errors++;		///	torn sample
+				if (!lv_first && (lv_s.ms <= lv_last)) lv_errors++;				///	wrong order
+				lv_last = lv_s.ms;
+				lv_first = false;
+				lv_received++;
+			}
+		});
+		std::thread lv_producer([&]() {
+			for (uint32_t i = 0; i < gv_nSamples; i++) {
+				while (lv_pass && lv_queue.full()) std::this_thread::yield();
+				lv_queue.push(makeSample(i));
+				///	drop: burst of 1.5 capacity, then let consumer work (one core too), queue is full and empty
+				if (!lv_pass && ((i % 96) == 95)) std::this_thread::yield();
+			}
+			__atomic_store_n(&lv_done, true, __ATOMIC_RELEASE);
+		});
+		lv_producer.join();
+		lv_consumer.join();
+
+		bool lv_ok = (lv_errors == 0) && (lv_pass ? (lv_received == gv_nSamples) && !lv_queue.overruns()
+			: (lv_received + lv_queue.overruns() == gv_nSamples) && (lv_received >= gv_nSamples / 10));
+		printf("numbered, %s: pushed %u, received %u, overruns %u, errors %u -> %s\n",
+			lv_pass ? "retry" : "drop", gv_nSamples, lv_received, lv_queue.overruns(), lv_errors, lv_ok ? "OK" : "FAIL");
+		if (!lv_ok) lv_fail++;
+	}
+
+	///	2. acquisition of simulated sensor in producer thread (virtual clock is used only there)
+	{
+		cl_VEMLqueue<16> lv_queue;
+		cl_VEMLsim lv_sim;
+		cl_VEML7700 lv_veml(lv_sim);
+		cl_VEMLlatest lv_latest;
+		cl_VEMLacq<16> lv_acq(lv_veml, lv_queue, &lv_latest);
+		const uint32_t lv_nSteps = 2000;
+		bool lv_done = false;
+		uint32_t lv_received = 0, lv_errors = 0;
+
+		simSetMillis(0);
+		lv_sim.setLux(350.0);
+		lv_veml.check();
+
+		std::thread lv_consumer([&]() {
+			VEMLsample_stru_t lv_s;
+			uint32_t lv_last = 0;
+			for (;;) {
+				bool lv_end = __atomic_load_n(&lv_done, __ATOMIC_ACQUIRE);
+				if (!lv_queue.pop(lv_s)) {
+					if (lv_end) break;
+					std::this_thread::yield();
+					continue;
+				}
+				if ((lv_s.aw.als1 < 349) || (lv_s.aw.als1 > 351)) lv_errors++;
+				if (lv_s.ms < lv_last) lv_errors++;
+				lv_last = lv_s.ms;
+				lv_received++;
+			}
+		});
+		std::thread lv_producer([&]() {
+			for (uint32_t i = 0; i < lv_nSteps; i++) {
+				lv_acq.step();
+				///	virtual clock make integration instant, real time of it let consumer work
+				std::this_thread::sleep_for(std::chrono::microseconds(20));
+			}
+			__atomic_store_n(&lv_done, true, __ATOMIC_RELEASE);
+		});
+		lv_producer.join();
+		lv_consumer.join();
+
+		VEMLsample_stru_t lv_s;
+		bool lv_ok = (lv_errors == 0) && (lv_received + lv_queue.overruns() == lv_nSteps)
+			&& (lv_received >= lv_nSteps * 99 / 100) && (lv_latest.count() == lv_nSteps) && lv_latest.read(lv_s) && (lv_s.aw.als1 == 350);
+		printf("acquisition: steps %u, received %u, overruns %u, latest %u, errors %u -> %s\n",
+			lv_nSteps, lv_received, lv_queue.overruns(), lv_latest.count(), lv_errors, lv_ok ? "OK" : "FAIL");
+		if (!lv_ok) lv_fail++;
+	}
+
+	///	3. latest sample (seqlock): one writer at full speed, 3 readers check that sample is not torn
+	{
+		const uint32_t lv_nPublish = gv_nSamples / 10;
+		cl_VEMLlatest lv_latest;
+		const uint8_t lv_nReaders = 3;
+		bool lv_done = false;
+		uint32_t lv_reads[lv_nReaders] = {}, lv_errors[lv_nReaders] = {};
+		std::thread lv_reader[lv_nReaders];
+
+		for (uint8_t r = 0; r < lv_nReaders; r++) {
+			lv_reader[r] = std::thread([&, r]() {
+				VEMLsample_stru_t lv_s;
+				uint32_t lv_last = 0;
+				while (!__atomic_load_n(&lv_done, __ATOMIC_ACQUIRE)) {
+					if (!lv_latest.tryRead(lv_s)) {
+						std::this_thread::yield();
+						continue;
+					}
+					if (!sameSample(lv_s, makeSample(lv_s.ms))) lv_errors[r]++;		///	torn sample
+					if (lv_s.ms < lv_last) lv_errors[r]++;							///	sample from past
+					lv_last = lv_s.ms;
+					lv_reads[r]++;
+				}
+			});
+		}
+		std::thread lv_writer([&]() {
+			for (uint32_t i = 1; i <= lv_nPublish; i++) {
+				lv_latest.publish(makeSample(i));
+				if ((i & 0xFF) == 0) std::this_thread::yield();		///	let readers meet writer on one core
+			}
+			__atomic_store_n(&lv_done, true, __ATOMIC_RELEASE);
+		});
+		lv_writer.join();
+		uint32_t lv_sumReads = 0, lv_sumErrors = 0;
+		for (uint8_t r = 0; r < lv_nReaders; r++) {
+			lv_reader[r].join();
+			lv_sumReads += lv_reads[r];
+			lv_sumErrors += lv_errors[r];
+		}
+
+		VEMLsample_stru_t lv_s;
+		bool lv_ok = (lv_sumErrors == 0) && (lv_latest.count() == lv_nPublish)
+			&& lv_latest.read(lv_s) && (lv_s.ms == lv_nPublish);
+		printf("latest: published %u, reads %u, errors %u -> %s\n",
+			lv_latest.count(), lv_sumReads, lv_sumErrors, lv_ok ? "OK" : "FAIL");
+		if (!lv_ok) lv_fail++;
+	}
+
+	return lv_fail;
+}
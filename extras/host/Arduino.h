@@ -0,0 +1,20 @@
+/**
+ * @brief	Minimal Arduino.h for host (Linux) build of mkigor_veml library with simulator.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	millis() and delay() work on virtual clock of veml_sim.cpp,
+ * 			delay() do not wait, it only move virtual clock forward.
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <math.h>
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+#endif
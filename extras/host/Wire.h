@@ -0,0 +1,25 @@
+/**
+ * @brief	Minimal Wire.h for host (Linux) build of mkigor_veml library with simulator.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	TwoWire here has no device on bus, every transaction return error.
+ * 			Sensor on host use cl_VEMLsim (veml_sim.h) as bus.
+ */
+
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+	void begin() {};
+	void beginTransmission(uint8_t) {};
+	size_t write(uint8_t) { return 1; };
+	uint8_t endTransmission(bool = true) { return 2; };	///	NACK on address
+	uint8_t requestFrom(uint8_t, unsigned long, bool = true) { return 0; };
+	int read() { return -1; };
+};
+
+extern TwoWire Wire;
+
+#endif
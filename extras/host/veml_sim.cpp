@@ -0,0 +1,192 @@
+/**
+ * @brief	Host (Linux) simulator of sensor light VEML7700 for mkigor_veml library.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	See veml_sim.h
+ */
+
+#include <veml_sim.h>
+
+//============================================================================================
+///	Virtual clock and host Arduino functions
+
+static uint32_t gv_simMs = 0;
+
+uint32_t millis() { return gv_simMs; }
+uint32_t micros() { return gv_simMs * 1000ul; }
+void delay(uint32_t ms) { gv_simMs += ms; }
+void simSetMillis(uint32_t lp_ms) { gv_simMs = lp_ms; }
+
+TwoWire Wire;
+
+//============================================================================================
+
+/**
+ * @brief integration time from ALS_IT <9:6> of ALS_CONF, unknown code work as 100 ms
+ */
+uint16_t cl_VEMLsim::clf_timeMs() {
+	switch ((clv_reg[cd_ALS_CONF] >> 6) & 0x0F) {
+		case 0x0C: return 25;
+		case 0x08: return 50;
+		case 0x01: return 200;
+		case 0x02: return 400;
+		case 0x03: return 800;
+		default:   return 100;
+	}
+}
+
+/**
+ * @brief time between conversions, integration time + wait time of PSM mode <2:1> if PSM_EN <0>
+ */
+uint16_t cl_VEMLsim::clf_periodMs() {
+	uint16_t lv_psm = clv_reg[cd_PSM];
+	if ((lv_psm & 0x0001) == 0) return clf_timeMs();
+	return clf_timeMs() + (500 << ((lv_psm >> 1) & 0x03));
+}
+
+/**
+ * @brief raw count for lux with current gain & time, 0.0672 lux/count at gain x1 and 100 ms,
+ * 			plus noise of setNoise()
+ */
+uint16_t cl_VEMLsim::clf_counts(float lp_lux) {
+	static const float lv_gainMul[4] = { 1.0, 2.0, 0.125, 0.25 };	///	ALS_GAIN <12:11>
+	float lv_counts = lp_lux / 0.0672 * lv_gainMul[(clv_reg[cd_ALS_CONF] >> 11) & 0x03]
+		* clf_timeMs() / 100.0;
+	if (clv_noise) {
+		clv_rand = clv_rand * 1103515245ul + 12345;		///	LCG, high bits are used
+		lv_counts += (int32_t)((clv_rand >> 16) % (2u * clv_noise + 1)) - clv_noise;
+	}
+	if (lv_counts <= 0) return 0;
+	if (lv_counts >= 65535.0) return 0xFFFF;
+	return (uint16_t)(lv_counts + 0.5);
+}
+
+/**
+ * @brief finish conversions, which end before millis(), and latch counts to ALS & WHITE
+ */
+void cl_VEMLsim::clf_update() {
+	if (clv_reg[cd_ALS_CONF] & 0x0001) return;		///	shut down, no counting
+	uint32_t lv_dt = millis() - clv_t0;
+	if (lv_dt < clf_timeMs()) return;
+	uint32_t lv_nConv = (lv_dt - clf_timeMs()) / clf_periodMs() + 1;
+	if (lv_nConv == clv_nConv) return;
+	uint32_t lv_nNew = lv_nConv - clv_nConv;
+	clv_nConv = lv_nConv;
+	clv_reg[cd_ALS] = clf_counts(clv_luxALS);
+	clv_reg[cd_WHITE] = clf_counts(clv_luxWHITE);
+	if (lv_nNew > 8) lv_nNew = 8;			///	max persistence, more conversions do not change flags
+	for (uint32_t i = 0; i < lv_nNew; i++) clf_checkInt(clv_reg[cd_ALS]);
+}
+
+/**
+ * @brief compare conversion with ALS_WH, ALS_WL and set flags of ALS_INT after ALS_PERS conversions
+ */
+void cl_VEMLsim::clf_checkInt(uint16_t lp_counts) {
+	uint16_t lv_conf = clv_reg[cd_ALS_CONF];
+	if ((lv_conf & 0x0002) == 0) return;			///	ALS_INT_EN
+	uint8_t lv_pers = 1 << ((lv_conf >> 4) & 0x03);	///	ALS_PERS 1, 2, 4, 8
+	clv_persHigh = (lp_counts > clv_reg[cd_ALS_WH]) ? clv_persHigh + 1 : 0;
+	clv_persLow = (lp_counts < clv_reg[cd_ALS_WL]) ? clv_persLow + 1 : 0;
+	if (clv_persHigh >= lv_pers) { clv_persHigh = lv_pers; clv_reg[cd_ALS_INT] |= cd_INT_TH_HIGH; }
+	if (clv_persLow >= lv_pers) { clv_persLow = lv_pers; clv_reg[cd_ALS_INT] |= cd_INT_TH_LOW; }
+}
+
+/**
+ * @brief write register from i2c, new gain, time, PSM or wake up restart integration
+ */
+void cl_VEMLsim::clf_writeReg(uint8_t lp_cmd, uint16_t lp_data) {
+	if ((lp_cmd != cd_ALS_CONF) && (lp_cmd != cd_ALS_WH) && (lp_cmd != cd_ALS_WL) && (lp_cmd != cd_PSM)) return;	///	read only
+	clf_update();
+	uint16_t lv_old = clv_reg[lp_cmd];
+	clv_reg[lp_cmd] = lp_data;
+	if ((lp_cmd == cd_ALS_CONF) && ((lv_old ^ lp_data) & 0x1BC0)) clv_nGTchange++;	///	gain <12:11>, time <9:6>
+	bool lv_restart = ((lp_cmd == cd_ALS_CONF) && ((lv_old ^ lp_data) & 0x1BC1))
+		|| ((lp_cmd == cd_PSM) && (lv_old != lp_data));
+	if (lv_restart) {
+		clv_t0 = millis();
+		clv_nConv = 0;
+	}
+}
+
+/**
+ * @brief set light on sensor, next conversions count this light
+ * @param lp_als - lux for ALS channel, lp_white - lux for WHITE channel (< 0 -> the same as ALS)
+ */
+void cl_VEMLsim::setLux(float lp_als, float lp_white) {
+	clf_update();
+	clv_luxALS = lp_als;
+	clv_luxWHITE = (lp_white < 0) ? lp_als : lp_white;
+}
+
+/**
+ * @brief read register of model without i2c transaction, for check in test
+ * @param lp_cmd - command code of register
+ */
+uint16_t cl_VEMLsim::peekReg(uint8_t lp_cmd) {
+	clf_update();
+	return clv_reg[lp_cmd & 0x07];
+}
+
+bool cl_VEMLsim::write(uint8_t lp_addr, const uint8_t *lp_data, uint8_t lp_len) {
+	if (lp_addr != clv_i2cAddr) return false;
+	clv_nTrans++;
+	if (lp_len == 0) return true;
+	clv_ptr = lp_data[0] & 0x07;
+	if (lp_len >= 3) clf_writeReg(clv_ptr, (uint16_t)lp_data[2] << 8 | lp_data[1]);
+	return true;
+}
+
+bool cl_VEMLsim::read(uint8_t lp_addr, uint8_t *lp_data, uint8_t lp_len) {
+	if (lp_addr != clv_i2cAddr) return false;
+	clv_nTrans++;
+	clf_update();
+	uint16_t lv_data = clv_reg[clv_ptr];
+	if (clv_ptr == cd_ALS_INT) clv_reg[cd_ALS_INT] = 0;		///	flags are cleared by read
+	for (uint8_t i = 0; i < lp_len; i++) lp_data[i] = (i & 1) ? (lv_data >> 8) : (lv_data & 0xFF);
+	return true;
+}
+
+bool cl_VEMLsim::writeRead(uint8_t lp_addr, const uint8_t *lp_wdata, uint8_t lp_wlen,
+		uint8_t *lp_rdata, uint8_t lp_rlen) {
+	if (lp_addr != clv_i2cAddr) return false;
+	if (lp_wlen) clv_ptr = lp_wdata[0] & 0x07;
+	bool lv_ok = read(lp_addr, lp_rdata, lp_rlen);
+	return lv_ok;		///	one transaction with repeated start
+}
+
+//============================================================================================
+
+bool cl_TCA9548Asim::write(uint8_t lp_addr, const uint8_t *lp_data, uint8_t lp_len) {
+	clv_nTrans++;
+	if (lp_addr == clv_i2cAddr) {
+		if (lp_len != 1) return false;
+		clv_control = lp_data[0];
+		clv_nSelect++;
+		return true;
+	}
+	bool lv_ack = false;
+	for (uint8_t i = 0; i < 8; i++)
+		if ((clv_control & (1 << i)) && clv_chan[i] && clv_chan[i]->write(lp_addr, lp_data, lp_len)) lv_ack = true;
+	return lv_ack;
+}
+
+bool cl_TCA9548Asim::read(uint8_t lp_addr, uint8_t *lp_data, uint8_t lp_len) {
+	clv_nTrans++;
+	if (lp_addr == clv_i2cAddr) {
+		if (lp_len) lp_data[0] = clv_control;
+		return true;
+	}
+	for (uint8_t i = 0; i < 8; i++)		///	the first device, which ACK, is read
+		if ((clv_control & (1 << i)) && clv_chan[i] && clv_chan[i]->read(lp_addr, lp_data, lp_len)) return true;
+	return false;
+}
+
+bool cl_TCA9548Asim::writeRead(uint8_t lp_addr, const uint8_t *lp_wdata, uint8_t lp_wlen,
+		uint8_t *lp_rdata, uint8_t lp_rlen) {
+	clv_nTrans++;
+	for (uint8_t i = 0; i < 8; i++)
+		if ((clv_control & (1 << i)) && clv_chan[i]
+				&& clv_chan[i]->writeRead(lp_addr, lp_wdata, lp_wlen, lp_rdata, lp_rlen)) return true;
+	return false;
+}
+
+//============================================================================================
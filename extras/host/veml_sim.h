@@ -0,0 +1,125 @@
+/**
+ * @brief	Host (Linux) simulator of sensor light VEML7700 for mkigor_veml library.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	cl_VEMLsim is a bus (cl_VEMLbus) with one simulated VEML7700 on it, so it is given
+ * 			to cl_VEML7700 constructor instead of Wire. Model has registers cd_ALS_CONF, cd_PSM,
+ * 			cd_ALS, cd_WHITE, cd_ID, gain & time scaling, latency of integration, PSM refresh,
+ * 			16 bit saturation, noise of count and shut down (ALS_SD). Interrupt: cd_ALS_WH, cd_ALS_WL, cd_ALS_INT
+ * 			with ALS_PERS and ALS_INT_EN, flags are cleared by read of cd_ALS_INT.
+ * 			millis() and delay() work on virtual clock, so 3 s of autorange take microseconds.
+ * 			Build, example:
+ * 			g++ -std=c++11 -I. -Iextras/host mkigor_veml*.cpp extras/host/veml_sim.cpp main.cpp
+ * @example
+ * 			cl_VEMLsim sim;
+ * 			cl_VEML7700 veml(sim);
+ * 			sim.setLux(300.0);
+ * 			veml.check();
+ * 			delay(800);
+ * 			AW_stru_t aw = veml.readAW();
+ */
+
+#include <Arduino.h>
+#include <mkigor_veml.h>
+
+#ifndef veml_sim_h
+#define veml_sim_h
+
+/// Set virtual clock, millis() return this value
+void simSetMillis(uint32_t lp_ms);
+
+//============================================================================================
+
+class cl_VEMLsim : public cl_VEMLbus {
+private:
+	uint8_t		clv_i2cAddr;
+	uint8_t		clv_ptr = 0;			///	command code of last write, read start from it
+	uint16_t	clv_reg[8] = { 0x0001, 0, 0, 0, 0, 0, 0, 0xC481 };	///	power on values
+	float		clv_luxALS = 0;
+	float		clv_luxWHITE = 0;
+	uint32_t	clv_t0 = 0;				///	millis() when integration start
+	uint32_t	clv_nConv = 0;			///	number of finished conversions from clv_t0
+	uint8_t		clv_persHigh = 0;		///	conversions in a row over ALS_WH
+	uint8_t		clv_persLow = 0;		///	conversions in a row under ALS_WL
+	uint32_t	clv_nTrans = 0;
+	uint32_t	clv_nGTchange = 0;
+	uint16_t	clv_noise = 0;			///	max noise of count, +- counts
+	uint32_t	clv_rand = 1;			///	state of pseudo random noise, the same sequence each run
+
+	uint16_t clf_timeMs();
+	uint16_t clf_periodMs();
+	uint16_t clf_counts(float lp_lux);
+	void clf_update();
+	void clf_checkInt(uint16_t lp_counts);
+	void clf_writeReg(uint8_t lp_cmd, uint16_t lp_data);
+
+public:
+	cl_VEMLsim(uint8_t lp_addr = 0x10) : clv_i2cAddr(lp_addr) {};
+
+/**
+ * @brief set light on sensor, next conversions count this light
+ * @param lp_als - lux for ALS channel, lp_white - lux for WHITE channel (< 0 -> the same as ALS)
+ */
+void setLux(float lp_als, float lp_white = -1);
+
+/**
+ * @brief add noise to each conversion, uniform integer -lp_counts .. +lp_counts, 0 - off (default)
+ */
+void setNoise(uint16_t lp_counts) { clv_noise = lp_counts; };
+
+/**
+ * @brief read register of model without i2c transaction, for check in test
+ * @param lp_cmd - command code of register
+ */
+uint16_t peekReg(uint8_t lp_cmd);
+
+/// Number of i2c transactions (write, read or write-read) to sensor
+uint32_t transactions() { return clv_nTrans; };
+
+/// Number of writes to ALS_CONF, that change gain or time
+uint32_t gtChanges() { return clv_nGTchange; };
+
+void resetStats() { clv_nTrans = 0; clv_nGTchange = 0; };
+
+bool write(uint8_t lp_addr, const uint8_t *lp_data, uint8_t lp_len) override;
+bool read(uint8_t lp_addr, uint8_t *lp_data, uint8_t lp_len) override;
+bool writeRead(uint8_t lp_addr, const uint8_t *lp_wdata, uint8_t lp_wlen,
+		uint8_t *lp_rdata, uint8_t lp_rlen) override;
+};
+
+//============================================================================================
+
+/**
+ * @brief	Host simulator of i2c mux TCA9548A, it is a bus with up to 8 channels (buses) behind it.
+ * @details	Write 1 byte to mux address set control register (bit per channel),
+ * 			other transactions go to enabled channels.
+ */
+class cl_TCA9548Asim : public cl_VEMLbus {
+private:
+	uint8_t		clv_i2cAddr;
+	uint8_t		clv_control = 0;			///	control register, bit per channel
+	cl_VEMLbus	*clv_chan[8] = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+	uint32_t	clv_nTrans = 0;
+	uint32_t	clv_nSelect = 0;
+
+public:
+	cl_TCA9548Asim(uint8_t lp_addr = 0x70) : clv_i2cAddr(lp_addr) {};
+
+/// connect bus (for example cl_VEMLsim) to channel 0 - 7
+void attach(uint8_t lp_channel, cl_VEMLbus &lp_bus) { clv_chan[lp_channel & 0x07] = &lp_bus; };
+
+/// Number of all i2c transactions on bus of mux
+uint32_t transactions() { return clv_nTrans; };
+
+/// Number of writes to control register of mux
+uint32_t selects() { return clv_nSelect; };
+
+void resetStats() { clv_nTrans = 0; clv_nSelect = 0; };
+
+bool write(uint8_t lp_addr, const uint8_t *lp_data, uint8_t lp_len) override;
+bool read(uint8_t lp_addr, uint8_t *lp_data, uint8_t lp_len) override;
+bool writeRead(uint8_t lp_addr, const uint8_t *lp_wdata, uint8_t lp_wlen,
+		uint8_t *lp_rdata, uint8_t lp_rlen) override;
+};
+
+#endif
+//============================================================================================
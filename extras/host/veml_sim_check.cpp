@@ -0,0 +1,387 @@
+/**
+ * @brief	Checks of mkigor_veml library on host simulator.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	Each check builds its own simulated sensors, prints OK / FAIL, and the program
+ * 			returns the number of failed checks.
+ * 			Build and run on Linux from root of library:
+ * 			g++ -std=c++11 -I. -Iextras/host mkigor_veml*.cpp extras/host/veml_sim.cpp \
+ * 				extras/host/veml_sim_check.cpp -o veml_sim_check && ./veml_sim_check
+ */
+
+#include <veml_sim.h>
+#include <mkigor_veml_rbe.h>
+#include <mkigor_veml_range.h>
+#include <mkigor_veml_group.h>
+
+static int gv_fail = 0;
+
+static void report(const char *lp_name, bool lp_ok) {
+	printf("%-40s %s\n", lp_name, lp_ok ? "OK" : "FAIL");
+	if (!lp_ok) gv_fail++;
+}
+
+//============================================================================================
+
+/// two sensors behind mux TCA9548A read own light, mux is written only when channel is changed
+static void checkMux() {
+	cl_TCA9548Asim lv_muxSim;
+	cl_VEMLsim lv_sim0, lv_sim1;
+	lv_muxSim.attach(0, lv_sim0);
+	lv_muxSim.attach(5, lv_sim1);
+	cl_TCA9548A lv_mux(lv_muxSim);
+	cl_TCA9548Achan lv_ch0(lv_mux, 0), lv_ch5(lv_mux, 5);
+	cl_VEML7700 lv_veml0(lv_ch0), lv_veml1(lv_ch5);
+
+	simSetMillis(0);
+	lv_sim0.setLux(300.0);
+	lv_sim1.setLux(5000.0);
+	bool lv_ok = (lv_veml0.check() == 0xC481) && (lv_veml1.check() == 0xC481);
+	delay(900);
+	lv_muxSim.resetStats();
+
+	///	order of sensors: 0 0 1 1 1 0 1 => 4 changes of channel, the first one from channel 5
+	const uint8_t lv_order[] = { 0, 0, 1, 1, 1, 0, 1 };
+	for (uint8_t i = 0; i < sizeof(lv_order); i++) {
+		uint32_t lv_lux = lv_order[i] ? lv_veml1.readAW().als1 : lv_veml0.readAW().als1;
+		if (lv_lux != (lv_order[i] ? 5000u : 300u)) lv_ok = false;
+	}
+	report("mux: own lux of channel", lv_ok);
+	report("mux: select only on channel change", lv_muxSim.selects() == 4);
+}
+
+/// back to back readHDR(): light is changed between calls, both exposures of next call see new light
+static void checkHDRfresh() {
+	cl_VEMLsim lv_sim;
+	cl_VEML7700 lv_veml(lv_sim);
+	simSetMillis(0);
+	lv_sim.setLux(100.0);
+	bool lv_ok = lv_veml.check() == 0xC481;
+	delay(900);
+	hdrExp_t lv_used;
+	for (uint8_t i = 0; i < 4; i++) {
+		float lv_lux = (i & 1) ? 400.0 : 100.0;
+		lv_sim.setLux(lv_lux);
+		uint32_t lv_als = lv_veml.readHDR(&lv_used).als1;
+		if ((lv_used != HDR_BOTH) || (lv_als + 2 < lv_lux) || (lv_als > lv_lux + 2)) lv_ok = false;
+	}
+	report("hdr: new light after back to back call", lv_ok);
+
+	///	each call: fresh count of kept exposure ~ readyMs(200) + changed exposure ~ readyMs(25)
+	bool lv_time = true;
+	for (uint8_t i = 0; i < 2; i++) {
+		uint32_t lv_t0 = millis();
+		lv_veml.readHDR();
+		uint32_t lv_ms = millis() - lv_t0;
+		if ((lv_ms < 225) || (lv_ms > cl_VEML7700::readyMs(0) + cl_VEML7700::readyMs(3))) lv_time = false;
+	}
+	report("hdr: time of back to back call", lv_time);
+}
+
+/// noise +- 3 counts at gain x2 800 ms: variance of readAWavg() is 4 counts^2 = 70.56 mlux^2
+static void checkAvgNoise() {
+	cl_VEMLsim lv_sim;
+	cl_VEML7700 lv_veml(lv_sim);
+	simSetMillis(0);
+	lv_sim.setLux(3.0);				///	714 counts at the most sensitive x2 800 ms
+	lv_sim.setNoise(3);
+	bool lv_ok = lv_veml.check() == 0xC481;
+	delay(900);
+	AWstat_stru_t lv_stat = lv_veml.readAWavg(200);
+	lv_ok = lv_ok && (lv_stat.gt.idxGain1 == 3) && (lv_stat.gt.idxTime1 == 5);
+	report("avg: noise give variance", lv_ok && (lv_stat.varMlux2 >= 50) && (lv_stat.varMlux2 <= 95));
+	report("avg: mean of noise", lv_ok && (lv_stat.meanMlux >= 2980) && (lv_stat.meanMlux <= 3020));
+
+	///	light change before call without ranging step: old count in register is not a sample
+	lv_sim.setNoise(0);
+	lv_sim.setLux(4.0);
+	lv_stat = lv_veml.readAWavg(8);
+	report("avg: no stale sample", (lv_stat.minLux == 4) && (lv_stat.maxLux == 4) && (lv_stat.varMlux2 == 0));
+}
+
+/// report by exception at 8 klux steady for 10 s, then step to 9 klux, i2c transactions of sample()
+static uint32_t rbeTransactions(bool lp_corr, bool &lp_ok) {
+	cl_VEMLsim lv_sim;
+	cl_VEML7700 lv_veml(lv_sim);
+	cl_VEMLrbe lv_rbe(lv_veml);
+	simSetMillis(0);
+	lv_sim.setLux(8000.0);
+	lp_ok = lv_veml.check() == 0xC481;
+	lv_veml.setCorrection(lp_corr);
+	delay(900);
+	AW_stru_t lv_AW;
+	lp_ok = lp_ok && lv_rbe.sample(lv_AW);				///	the first sample is always emitted
+	lv_sim.resetStats();
+	uint32_t lv_t0 = millis();
+	while ((uint32_t)(millis() - lv_t0) < 10000) {
+		if (lv_rbe.sample(lv_AW)) lp_ok = false;		///	steady light, nothing to emit
+		delay(1);
+	}
+	uint32_t lv_trans = lv_sim.transactions();
+	lv_sim.setLux(9000.0);
+	bool lv_step = false;
+	for (lv_t0 = millis(); !lv_step && ((uint32_t)(millis() - lv_t0) < 1000); delay(1)) lv_step = lv_rbe.sample(lv_AW);
+	lp_ok = lp_ok && lv_step;
+	return lv_trans;
+}
+
+/// ranging policy, which keep gain & time
+class cl_rangeHold : public cl_VEMLrange {
+public:
+bool next(uint16_t lp_ALSdata, GTidx_stru_t &lp_gt) override { (void)lp_ALSdata; (void)lp_gt; return false; };
+};
+
+/// thresholds of report by exception at 1/4 800 ms (0.0336 lux/count) with correction: exact to one count
+static void checkRbeBand() {
+	cl_VEMLsim lv_sim;
+	cl_VEML7700 lv_veml(lv_sim);
+	cl_VEMLrbe lv_rbe(lv_veml);
+	cl_rangeHold lv_hold;
+	simSetMillis(0);
+	lv_sim.setLux(400.0);
+	bool lv_ok = lv_veml.check() == 0xC481;
+	lv_veml.setRangePolicy(lv_hold);
+	lv_veml.setCorrection(true);
+	lv_veml.startConversion(1, 5);
+	delay(900);
+	lv_rbe.setDelta(5, 0);
+	AW_stru_t lv_AW;
+	lv_ok = lv_ok && lv_rbe.sample(lv_AW);
+	const GTidx_stru_t lv_gt = { 1, 5 };
+	uint32_t lv_last = lv_rbe.last().als1;
+	uint16_t lv_WL = lv_sim.peekReg(cd_ALS_WL), lv_WH = lv_sim.peekReg(cd_ALS_WH);
+	///	count WH is in band, WH + 1 emit, count WL is in band, WL - 1 emit
+	lv_ok = lv_ok && (cl_VEML7700::countsToLuxCorr(lv_WH, lv_gt) < lv_last + 5)
+		&& (cl_VEML7700::countsToLuxCorr(lv_WH + 1, lv_gt) >= lv_last + 5)
+		&& (cl_VEML7700::countsToLuxCorr(lv_WL, lv_gt) > lv_last - 5)
+		&& (cl_VEML7700::countsToLuxCorr(lv_WL - 1, lv_gt) <= lv_last - 5);
+	report("rbe: band of corrected lux to one count", lv_ok);
+}
+
+/// with correction of nonlinearity band of sensor is in counts, so steady light cost the same i2c
+static void checkRbeCorr() {
+	bool lv_okLin, lv_okCorr;
+	uint32_t lv_lin = rbeTransactions(false, lv_okLin);
+	uint32_t lv_corr = rbeTransactions(true, lv_okCorr);
+	report("rbe: steady light and step", lv_okLin && lv_okCorr);
+	report("rbe: correction cost no more i2c", lv_corr <= lv_lin + 4);
+}
+
+/// deadline ranging: light out of window at the least / the most sensitive gain & time is precise
+static void checkLatencyMet() {
+	cl_VEMLsim lv_sim;
+	cl_VEML7700 lv_veml(lv_sim);
+	simSetMillis(0);
+	lv_sim.setLux(30000.0);				///	13951 counts at 1/8 25 ms, over window
+	bool lv_ok = lv_veml.check() == 0xC481;
+	delay(900);
+	bool lv_precise = false;
+	uint32_t lv_lux = lv_veml.readAW(5000, &lv_precise).als1;
+	GTidx_stru_t lv_gt = lv_veml.readGainTime();
+	report("latency: least sensitive is precise", lv_ok && lv_precise && (lv_gt.idxGain1 == 0) && (lv_gt.idxTime1 == 0)
+		&& (lv_lux + 3 >= 30000) && (lv_lux <= 30003));
+	lv_sim.setLux(1.0);					///	238 counts at x2 800 ms, under window
+	delay(50);							///	conversion of 25 ms with new light
+	lv_lux = lv_veml.readAW(5000, &lv_precise).als1;
+	report("latency: most sensitive is precise", lv_precise && (lv_lux == 1));
+	lv_sim.setLux(30000.0);
+	delay(900);
+	lv_veml.readAW(5000, &lv_precise);
+	lv_sim.setLux(1.0);
+	delay(50);
+	lv_veml.readAW(100, &lv_precise);	///	800 ms is out of budget
+	report("latency: cut by budget is not precise", !lv_precise);
+}
+
+/// interrupt by thresholds: flag on crossing high & low, clear by read, persistence, disable
+static void checkInt() {
+	cl_VEMLsim lv_sim;
+	cl_VEML7700 lv_veml(lv_sim);
+	simSetMillis(0);
+	lv_sim.setLux(300.0);
+	bool lv_ok = lv_veml.check() == 0xC481;
+	///	x2 100 ms: 8929 counts, conversion end each 100 ms after start
+	lv_veml.startConversion(3, 2);
+	lv_veml.setThresholds(200, 400);
+	delay(150);
+	lv_ok = lv_ok && (lv_veml.readInt() == 0);
+	report("int: no flag in band", lv_ok);
+
+	lv_sim.setLux(500.0);
+	delay(100);
+	report("int: flag high on crossing", lv_veml.readInt() == cd_INT_TH_HIGH);
+	report("int: flag is cleared by read", lv_veml.readInt() == 0);
+	lv_sim.setLux(100.0);
+	delay(100);
+	report("int: flag low on crossing", lv_veml.readInt() == cd_INT_TH_LOW);
+
+	///	ALS_PERS code 2: flag after 4 conversions in a row out of band
+	lv_sim.setLux(300.0);
+	lv_veml.setThresholds(200, 400, 2);
+	delay(100);
+	lv_veml.readInt();
+	lv_sim.setLux(500.0);
+	delay(300);
+	lv_ok = lv_veml.readInt() == 0;
+	delay(100);
+	report("int: persistence of 4 conversions", lv_ok && (lv_veml.readInt() == cd_INT_TH_HIGH));
+
+	lv_veml.disableInt();
+	lv_sim.setLux(100.0);
+	delay(100);
+	report("int: no flag if disabled", lv_veml.readInt() == 0);
+}
+
+/// PSM: sample once per period on schedule of the first one (no drift by late calls), stop PSM
+static void checkPSM() {
+	cl_VEMLsim lv_sim;
+	cl_VEML7700 lv_veml(lv_sim);
+	simSetMillis(0);
+	lv_sim.setLux(300.0);
+	bool lv_ok = lv_veml.check() == 0xC481;
+	///	x2 100 ms, PSM mode 1: period 100 + 500 ms
+	lv_veml.startPSM(1, 3, 2);
+	uint32_t lv_first = lv_veml.readyAt();
+	uint16_t lv_period = lv_veml.psmPeriod();
+	AW_stru_t lv_AW;
+	uint8_t lv_n = 0;
+	for (uint32_t lv_t0 = millis(); (uint32_t)(millis() - lv_t0) < 6000; delay(7)) {
+		if (!lv_veml.psmSample(lv_AW)) continue;
+		uint32_t lv_due = lv_first + lv_n * lv_period;
+		if (((int32_t)(millis() - lv_due) < 0) || (millis() - lv_due >= 7) || (lv_AW.als1 != 300)) lv_ok = false;
+		lv_n++;
+	}
+	report("psm: sample per period on schedule", lv_ok && (lv_period == 600) && (lv_n == 10));
+
+	lv_veml.stopPSM();
+	lv_ok = lv_veml.readyAt() == millis() + cl_VEML7700::readyMs(2);
+	lv_sim.setLux(500.0);
+	delay(lv_veml.readyAt() - millis());
+	report("psm: stop restart conversion", lv_ok && (lv_veml.collect().als == 14881));
+}
+
+/// non-blocking measurement just after wake up: the first poll() wait for conversion
+static void checkPollFirst() {
+	cl_VEMLsim lv_sim;
+	cl_VEML7700 lv_veml(lv_sim);
+	simSetMillis(0);
+	lv_sim.setLux(300.0);
+	bool lv_ok = lv_veml.check() == 0xC481;
+	lv_veml.beginMeasure();
+	lv_sim.resetStats();
+	lv_ok = lv_ok && (lv_veml.poll() == MEAS_PENDING) && (lv_sim.transactions() == 0);
+	while (lv_veml.poll() == MEAS_PENDING) delay(1);
+	report("poll: first read after conversion", lv_ok && (lv_veml.result().als1 == 300));
+}
+
+/**
+ * @brief 4 sensors behind mux TCA9548A from power on, measured one by one by readAW() or by group
+ * @param lp_group - use cl_VEMLgroup, lp_ms - time of measurement, lp_services - number of poll()
+ * 			of sensors, which read it (ranging steps + 1), lp_selects - writes to mux
+ * @return true if lux of each sensor is right
+ */
+static bool groupRun(bool lp_group, uint32_t &lp_ms, uint32_t &lp_services, uint32_t &lp_selects) {
+	const float lv_lux[4] = { 0.5, 50.0, 5000.0, 90000.0 };
+	cl_TCA9548Asim lv_muxSim;
+	cl_VEMLsim lv_sim[4];
+	cl_TCA9548A lv_mux(lv_muxSim);
+	cl_TCA9548Achan lv_ch0(lv_mux, 0), lv_ch2(lv_mux, 2), lv_ch4(lv_mux, 4), lv_ch6(lv_mux, 6);
+	cl_VEML7700 lv_veml0(lv_ch0), lv_veml2(lv_ch2), lv_veml4(lv_ch4), lv_veml6(lv_ch6);
+	cl_VEML7700 *lv_veml[4] = { &lv_veml0, &lv_veml2, &lv_veml4, &lv_veml6 };
+	cl_VEMLgroup lv_group;
+	bool lv_ok = true;
+
+	simSetMillis(0);
+	for (uint8_t i = 0; i < 4; i++) {
+		lv_muxSim.attach(2 * i, lv_sim[i]);
+		lv_sim[i].setLux(lv_lux[i]);
+		if (lv_veml[i]->check() != 0xC481) lv_ok = false;
+		lv_group.add(*lv_veml[i]);
+	}
+	lv_muxSim.resetStats();
+	AW_stru_t lv_AW[4];
+	uint32_t lv_t0 = millis();
+	if (lp_group) lv_group.readAll(lv_AW);
+	else for (uint8_t i = 0; i < 4; i++) lv_AW[i] = lv_veml[i]->readAW();
+	lp_ms = millis() - lv_t0;
+	lp_selects = lv_muxSim.selects();
+	lp_services = 0;
+	for (uint8_t i = 0; i < 4; i++) {
+		lp_services += lv_veml[i]->steps() + 1;
+		float lv_err = lv_AW[i].als1 - lv_lux[i];
+		if ((lv_err > 1 + lv_lux[i] / 1000) || (lv_err < -1 - lv_lux[i] / 1000)) lv_ok = false;
+	}
+	return lv_ok;
+}
+
+/// group of sensors behind mux: own lux of each sensor, in parallel faster, mux select per service only
+static void checkGroup() {
+	uint32_t lv_seqMs, lv_grpMs, lv_services, lv_selects;
+	bool lv_okSeq = groupRun(false, lv_seqMs, lv_services, lv_selects);
+	bool lv_okGrp = groupRun(true, lv_grpMs, lv_services, lv_selects);
+	printf("group: one by one %u ms, group %u ms, services %u, selects %u\n", lv_seqMs, lv_grpMs, lv_services, lv_selects);
+	report("group: own lux of each sensor", lv_okSeq && lv_okGrp);
+	report("group: faster than one by one", lv_grpMs < lv_seqMs);
+	report("group: mux select only per service", (lv_selects >= 4) && (lv_selects <= lv_services));
+}
+
+/**
+ * @brief step of light lp_from -> lp_to lux, filtered lux of readAWcont() must go to lp_target monotonic
+ * @param lp_veml - sensor with filter, it is init here, lp_samples - samples after step
+ */
+static bool filterStep(cl_VEMLsim &lp_sim, cl_VEML7700 &lp_veml, float lp_from, float lp_to,
+		uint32_t lp_target, uint8_t lp_samples) {
+	simSetMillis(0);
+	lp_sim.setLux(lp_from);
+	bool lv_ok = lp_veml.check() == 0xC481;
+	delay(900);
+	for (uint8_t i = 0; i < 10; i++) lp_veml.readAWcont();
+	lp_veml.resetFilter();
+	uint32_t lv_last = lp_veml.readAWcont().als1;
+	lp_sim.setLux(lp_to);
+	for (uint8_t i = 0; i < lp_samples; i++) {
+		uint32_t lv_lux = lp_veml.readAWcont().als1;
+		if ((lp_to > lp_from) ? (lv_lux < lv_last) : (lv_lux > lv_last)) lv_ok = false;	///	wrap or overshoot
+		lv_last = lv_lux;
+	}
+	return lv_ok && (lv_last + 1 >= lp_target) && (lv_last <= lp_target + 1);
+}
+
+/// fixed point EMA & Kalman: step response converge, saturated count at max shift do not overflow
+static void checkFilter() {
+	cl_VEMLsim lv_sim;
+	cl_VEML7700 lv_veml(lv_sim);
+	lv_veml.setFilterEMA(2);
+	report("filter: EMA step up", filterStep(lv_sim, lv_veml, 300.0, 600.0, 600, 40));
+	report("filter: EMA step down", filterStep(lv_sim, lv_veml, 600.0, 300.0, 300, 40));
+	lv_veml.setFilterKalman(1000000, 1);
+	report("filter: Kalman step up", filterStep(lv_sim, lv_veml, 300.0, 600.0, 600, 40));
+
+	///	200 klux: 65535 counts at 1/8 25 ms (shift 9), linear 140926 lux, corrected is cut to 2e6 lux
+	uint32_t lv_sat = cl_VEML7700::countsToLux(0xFFFF, { 0, 0 });
+	lv_veml.setFilterEMA(3);
+	report("filter: EMA saturation", filterStep(lv_sim, lv_veml, 10.0, 200000.0, lv_sat, 200));
+	lv_veml.setFilterKalman(0xFFFFFFFF, 255);
+	report("filter: Kalman saturation", filterStep(lv_sim, lv_veml, 10.0, 200000.0, lv_sat, 60));
+	lv_veml.setCorrection(true);
+	lv_veml.setFilterEMA(1);
+	report("filter: EMA saturation corrected", filterStep(lv_sim, lv_veml, 10.0, 200000.0, 2000000, 60));
+	lv_veml.setFilterKalman(0xFFFFFFFF, 255);
+	report("filter: Kalman saturation corrected", filterStep(lv_sim, lv_veml, 10.0, 200000.0, 2000000, 60));
+}
+
+//============================================================================================
+
+int main() {
+	checkMux();
+	checkHDRfresh();
+	checkAvgNoise();
+	checkRbeCorr();
+	checkRbeBand();
+	checkLatencyMet();
+	checkInt();
+	checkPSM();
+	checkPollFirst();
+	checkGroup();
+	checkFilter();
+	return gv_fail;
+}
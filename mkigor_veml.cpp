@@ -28,6 +28,7 @@
  */
 
 #include <mkigor_veml.h>
+#include <mkigor_veml_range.h>
 
 /*
 Short graph structure of registers VEML7700
@@ -66,23 +67,24 @@ Short graph structure of registers VEML7700
 
 //============================================================================================
 
+constexpr gainDesc_stru_t cl_VEML7700::clv_gainDesc[cl_VEML7700::clv_nGain];
+constexpr timeDesc_stru_t cl_VEML7700::clv_timeDesc[cl_VEML7700::clv_nTime];
+constexpr uint8_t cl_VEML7700::clv_psmIdd[4] [4];
+
+///	Built-in policies of ranging, they have no state, so one copy for all sensors
+static cl_VEMLrangeStep		gv_rangeStep;
+static cl_VEMLrangePredict	gv_rangePredict;
+
 /**
  * @brief Read 16 bit register of command code = command.
  * @param command - command code of 16 bit register
  * @return data 16 bit register = command.
  */
 uint16_t cl_VEML7700::readReg(uint8_t command) {
-	uint8_t lv_lsb, lv_msb;
-	uint16_t lv_data = 0;
+	uint8_t lv_buf[2] = { 0, 0 };	///	lsb, msb
 
-	Wire.beginTransmission(clv_i2cAddr);
-	Wire.write(command);
-	Wire.endTransmission(false);		///	don't send stop bit here
-	Wire.requestFrom(clv_i2cAddr, 2ul, true);	/// stop bit after request
-	lv_lsb = Wire.read();
-	lv_msb = Wire.read();
-	lv_data = lv_msb << 8 | lv_lsb;
-	return lv_data;
+	clf_bus().writeRead(clv_i2cAddr, &command, 1, lv_buf, 2);
+	return (uint16_t)lv_buf[1] << 8 | lv_buf[0];
 }
 
 /**
@@ -91,13 +93,8 @@ uint16_t cl_VEML7700::readReg(uint8_t command) {
  * @param data to be write (uint16_t).
  */
 void cl_VEML7700::writeReg(uint8_t command, uint16_t data) {
-	uint8_t lv_lsb = uint8_t(data & 0x00FF);
-	uint8_t lv_msb = uint8_t(data >> 8);
-	Wire.beginTransmission(clv_i2cAddr);
-	Wire.write(command);
-	Wire.write(lv_lsb);
-	Wire.write(lv_msb);
-	Wire.endTransmission();
+	uint8_t lv_buf[3] = { command, uint8_t(data & 0x00FF), uint8_t(data >> 8) };
+	clf_bus().write(clv_i2cAddr, lv_buf, 3);
 }
 
 /**
@@ -107,34 +104,56 @@ void cl_VEML7700::writeReg(uint8_t command, uint16_t data) {
  */
 uint16_t cl_VEML7700::check(uint8_t lp_addr) {
 	clv_i2cAddr = lp_addr;
-	uint8_t lv_lsb, lv_msb;
-	uint16_t lv_chipCode = 0;
+	uint8_t lv_cmd = cd_ID;
+	uint8_t lv_buf[2];	///	lsb, msb
 
-	Wire.beginTransmission(clv_i2cAddr);
-	if (Wire.write(cd_ID) != 1)			return 0;
-	if (Wire.endTransmission(false))	return 0;	///	don't send stop bit here
-	if (Wire.requestFrom(clv_i2cAddr, 2ul, true) != 2) return 0;
-	lv_lsb = Wire.read();
-	lv_msb = Wire.read();
-	lv_chipCode = lv_msb << 8 | lv_lsb;
+	if (!clf_bus().writeRead(clv_i2cAddr, &lv_cmd, 1, lv_buf, 2)) return 0;
+	uint16_t lv_chipCode = (uint16_t)lv_buf[1] << 8 | lv_buf[0];
 
 	///	write 0 PSM regs -> swich off PSM
-	writeReg(cd_PSM, 0);
+	clv_PSM = 0;
+	writeReg(cd_PSM, clv_PSM);
 	///	init command code ALS_CONF:
 	///	ALS gain x (1/8), ALS integration time 100 ms, ALS INT disable, ALS power on (wake up)
-	writeReg(cd_ALS_CONF, 0x1000);
+	clf_writeConf(0x1000);
 
 	return lv_chipCode;
 }
 
+/**
+ * @brief Read ALS_CONF & PSM registers from sensor to shadow copy in class.
+ * @details	Methods sleep(), wakeUp(), writeGainTime(), readGainTime() use only the copy and
+ * 			do not read sensor. Call it after i2c bus error or if someone else write to sensor.
+ * @return true if OK, false if i2c error, shadow copy is not changed then
+ */
+bool cl_VEML7700::resync() {
+	uint8_t lv_cmd[2] = { cd_ALS_CONF, cd_PSM };
+	uint8_t lv_conf[2], lv_psm[2];	///	lsb, msb
+	if (!clf_bus().writeRead(clv_i2cAddr, &lv_cmd[0], 1, lv_conf, 2)) return false;
+	if (!clf_bus().writeRead(clv_i2cAddr, &lv_cmd[1], 1, lv_psm, 2)) return false;
+	clv_ALSconf = (uint16_t)lv_conf[1] << 8 | lv_conf[0];
+	clv_PSM = (uint16_t)lv_psm[1] << 8 | lv_psm[0];
+	return true;
+}
+
+/**
+ * @brief write ALS_CONF register and keep shadow copy of it
+ * @param lp_ALSconf - new value of ALS_CONF
+ */
+void cl_VEML7700::clf_writeConf(uint16_t lp_ALSconf) {
+	///	new gain <12:11>, time <9:6> or wake up <0> => sensor start new conversion
+	if (((clv_ALSconf ^ lp_ALSconf) & 0x1BC1) && !(lp_ALSconf & 0x0001)) clv_convStart = millis();
+	clv_ALSconf = lp_ALSconf;
+	writeReg(cd_ALS_CONF, clv_ALSconf);
+}
+
 /**
  * @brief sent sensor to shut down, min power.
  * @details	all config settings are save,
  * after wakeUp sensor will start count with the same parameters
  */
 void cl_VEML7700::sleep() {
-	uint16_t lv_reg16 = readReg(cd_ALS_CONF);
-	writeReg(cd_ALS_CONF, lv_reg16 | 0x0001);
+	clf_writeConf(clv_ALSconf | 0x0001);
 }
 
 /**
@@ -142,8 +161,7 @@ void cl_VEML7700::sleep() {
  * @details All config settings are the same before shut down.
  */
 void cl_VEML7700::wakeUp() {
-	uint16_t lv_reg16 = readReg(cd_ALS_CONF);
-	writeReg(cd_ALS_CONF, lv_reg16 & 0xFFFE);
+	clf_writeConf(clv_ALSconf & 0xFFFE);
 }
 
 /**
@@ -152,88 +170,537 @@ void cl_VEML7700::wakeUp() {
  * @param lp_idxGain index of gain (0 - 3), lp_idxTime index of time (0 - 5)
  */
 void cl_VEML7700::writeGainTime(uint8_t lp_idxGain, uint8_t lp_idxTime) {
-	uint16_t lv_ALSconf = readReg(cd_ALS_CONF);
-	lv_ALSconf = lv_ALSconf & 0xE43F;	///	0b 1110 0100 0011 1111 - zero mask for gain & time
-	lv_ALSconf = lv_ALSconf | ((uint16_t)clv_ALSgain[lp_idxGain])<<11 | ((uint16_t)clv_ALStime[lp_idxTime])<<6;
-	writeReg(cd_ALS_CONF, lv_ALSconf);
+	uint16_t lv_ALSconf = clv_ALSconf & 0xE43F;	///	0b 1110 0100 0011 1111 - zero mask for gain & time
+	lv_ALSconf = lv_ALSconf | ((uint16_t)clv_gainDesc[lp_idxGain].code)<<11 | ((uint16_t)clv_timeDesc[lp_idxTime].code)<<6;
+	clf_writeConf(lv_ALSconf);
+	if (clv_ALSconf & 0x0002) clf_writeThresholds();	///	ALS_INT_EN, thresholds are counts of gain & time
 }
 
 /**
- * @brief read value of gain & time, read 16 bit raw data ALS, WHITE
+ * @brief read value of gain & time from shadow copy of ALS_CONF, no i2c transaction
  * 
- * @return GTrawAW_stru_t = {uint8_t GT, uint16_t ALS, uint16_t WHITE}
+ * @return GTidx_stru_t = {uint8_t index of gain, uint8_t index of time}
  */
 GTidx_stru_t cl_VEML7700::readGainTime() {
 	uint8_t lv_gainIndex = 0;
 	uint8_t lv_timeIndex = 0;
-	uint16_t lv_ALSconf = readReg(cd_ALS_CONF);
-	uint8_t lv_gain = (lv_ALSconf >> 11) & 0x03;
-	uint8_t lv_time = (lv_ALSconf >> 6) & 0x0F;
+	uint8_t lv_gain = (clv_ALSconf >> 11) & 0x03;
+	uint8_t lv_time = (clv_ALSconf >> 6) & 0x0F;
 	///	find index
-	for (uint8_t i = 0; i < clv_nGain; i++) if (lv_gain == clv_ALSgain[i]) lv_gainIndex = i;
-	for (uint8_t i = 0; i < clv_nTime; i++) if (lv_time == clv_ALStime[i]) lv_timeIndex = i;
+	for (uint8_t i = 0; i < clv_nGain; i++) if (lv_gain == clv_gainDesc[i].code) lv_gainIndex = i;
+	for (uint8_t i = 0; i < clv_nTime; i++) if (lv_time == clv_timeDesc[i].code) lv_timeIndex = i;
 	return {lv_gainIndex, lv_timeIndex};
 }
 
+/**
+ * @brief write thresholds clv_thLow, clv_thHigh to ALS_WL, ALS_WH as counts of current gain & time
+ */
+void cl_VEML7700::clf_writeThresholds() {
+	GTidx_stru_t lv_gt = readGainTime();
+	writeReg(cd_ALS_WL, luxToCounts(clv_thLow, lv_gt));
+	writeReg(cd_ALS_WH, luxToCounts(clv_thHigh, lv_gt));
+}
+
+/**
+ * @brief arm interrupt, when ALS is out of band lp_luxLow .. lp_luxHigh
+ * @details	lux is calc to raw counts of current gain & time and write to ALS_WL, ALS_WH,
+ * 			if gain & time is changed by ranging, thresholds are written again.
+ * 			Flag of interrupt is read by readInt(), pin INT of sensor go low.
+ * @param lp_luxLow, lp_luxHigh - band in lux,
+ * 			lp_pers - ALS_PERS code 0 - 3 = number of conversions out of band 1, 2, 4, 8 to set flag
+ */
+void cl_VEML7700::setThresholds(uint32_t lp_luxLow, uint32_t lp_luxHigh, uint8_t lp_pers) {
+	clv_thLow = lp_luxLow;
+	clv_thHigh = lp_luxHigh;
+	clf_writeThresholds();
+	///	ALS_PERS <5:4>, ALS_INT_EN <1>
+	clf_writeConf((clv_ALSconf & 0xFFCD) | ((uint16_t)(lp_pers & 0x03) << 4) | 0x0002);
+}
+
+/**
+ * @brief arm interrupt, when raw ALS count of current gain & time is out of band lp_low .. lp_high
+ * @details	counts are written to ALS_WL, ALS_WH as they are, so band is exact to one count.
+ * 			If gain & time is changed by ranging, thresholds are written again from linear lux
+ * 			of these counts.
+ * @param lp_low, lp_high - band in raw counts,
+ * 			lp_pers - ALS_PERS code 0 - 3 = number of conversions out of band 1, 2, 4, 8 to set flag
+ */
+void cl_VEML7700::setThresholdCounts(uint16_t lp_low, uint16_t lp_high, uint8_t lp_pers) {
+	GTidx_stru_t lv_gt = readGainTime();
+	clv_thLow = countsToLux(lp_low, lv_gt);
+	clv_thHigh = countsToLux(lp_high, lv_gt);
+	writeReg(cd_ALS_WL, lp_low);
+	writeReg(cd_ALS_WH, lp_high);
+	///	ALS_PERS <5:4>, ALS_INT_EN <1>
+	clf_writeConf((clv_ALSconf & 0xFFCD) | ((uint16_t)(lp_pers & 0x03) << 4) | 0x0002);
+}
+
+/**
+ * @brief disable interrupt, clear ALS_INT_EN
+ */
+void cl_VEML7700::disableInt() {
+	clf_writeConf(clv_ALSconf & 0xFFFD);
+}
+
+/**
+ * @brief read and clear flags of interrupt, sensor clear ALS_INT register by read
+ * @return cd_INT_TH_LOW | cd_INT_TH_HIGH or 0 if light was in band
+ */
+uint16_t cl_VEML7700::readInt() {
+	return readReg(cd_ALS_INT) & (cd_INT_TH_LOW | cd_INT_TH_HIGH);
+}
+
+/**
+ * @brief start periodic sampling in power saving mode (PSM)
+ * @details	sensor count lp_idxTime, then wait 500, 1000, 2000 or 4000 ms by PSM mode and so on.
+ * 			Take samples by psmSample(), it read sensor only if fresh conversion is due.
+ * @param lp_mode - PSM mode 1 - 4 (0 - PSM off, continuous counting),
+ * 			lp_idxGain index of gain (0 - 3), lp_idxTime index of time (0 - 5)
+ */
+void cl_VEML7700::startPSM(uint8_t lp_mode, uint8_t lp_idxGain, uint8_t lp_idxTime) {
+	clv_psmGT = { lp_idxGain, lp_idxTime };
+	clv_ALSconf |= 0x0001;		/// Shut down to change config, sensor start count after wake up
+	writeGainTime(lp_idxGain, lp_idxTime);
+	///	PSM <2:1> = mode - 1, PSM_EN <0>
+	clv_PSM = (lp_mode == 0) ? 0 : ((uint16_t)((lp_mode - 1) & 0x03) << 1) | 0x0001;
+	writeReg(cd_PSM, clv_PSM);
+	wakeUp();
+	clv_psmNext = readyAt();
+}
+
+/**
+ * @brief stop power saving mode, sensor count continuous
+ */
+void cl_VEML7700::stopPSM() {
+	clv_PSM = 0;
+	writeReg(cd_PSM, clv_PSM);
+	clv_convStart = millis();	///	sensor restart counting, readyAt() is from now
+}
+
+/**
+ * @brief refresh period of sensor with current PSM mode & time
+ * @return ms between fresh conversions = time + wait time of PSM
+ */
+uint16_t cl_VEML7700::psmPeriod() {
+	uint16_t lv_ms = clv_timeDesc[readGainTime().idxTime1].ms;
+	if ((clv_PSM & 0x0001) == 0) return lv_ms;
+	return lv_ms + (500 << ((clv_PSM >> 1) & 0x03));
+}
+
+/**
+ * @brief supply current of sensor with current PSM mode & time by datasheet
+ * @details	datasheet has table for time 100 .. 800 ms, for 25 & 50 ms value of 100 ms is returned
+ * @return uA
+ */
+uint8_t cl_VEML7700::psmCurrent() {
+	if ((clv_PSM & 0x0001) == 0) return clv_activeIdd;
+	uint8_t lv_idxTime = readGainTime().idxTime1;
+	uint8_t lv_row = (lv_idxTime < 2) ? 0 : lv_idxTime - 2;
+	return clv_psmIdd[lv_row][(clv_PSM >> 1) & 0x03];
+}
+
+/**
+ * @brief take sample in PSM, read ALS & WHITE only if fresh conversion is due
+ * @param lp_AW - result in lux, is changed only if fn return true
+ * @return true - new sample is in lp_AW, false - no fresh conversion yet, no i2c transaction
+ */
+bool cl_VEML7700::psmSample(AW_stru_t &lp_AW) {
+	uint32_t lv_now = millis();
+	if ((int32_t)(lv_now - clv_psmNext) < 0) return false;	///	safe for millis() overflow
+	uint16_t lv_ALSdata = readReg(cd_ALS);
+	uint16_t lv_WHITEda = readReg(cd_WHITE);
+	lp_AW = clf_calcAW(lv_ALSdata, lv_WHITEda, clv_psmGT);
+	uint16_t lv_period = psmPeriod();
+	do clv_psmNext += lv_period;			///	skip periods, which were missed
+	while ((int32_t)(lv_now - clv_psmNext) >= 0);
+	return true;
+}
+
+/**
+ * @brief policy of ranging, built-in RANGE_STEP if it was not set
+ */
+cl_VEMLrange &cl_VEML7700::clf_range() {
+	if (clv_range) return *clv_range;
+	return gv_rangeStep;
+}
+
+/**
+ * @brief set mode of ranging gain & time for readAW() and poll()
+ * @param lp_mode - RANGE_STEP (default) one index per integration,
+ * 			RANGE_PREDICT jump to proper gain & time by clf_tableResol, usually 1 - 2 integrations.
+ * 			If raw count is 0 or 65535 (saturation) RANGE_PREDICT do one step as RANGE_STEP.
+ */
+void cl_VEML7700::setRangeMode(rangeMode_t lp_mode) {
+	if (lp_mode == RANGE_PREDICT) clv_range = &gv_rangePredict;
+	else clv_range = &gv_rangeStep;
+}
+
+/**
+ * @brief set new gain & time, sensor restart counting
+ * @param lp_gt - index of gain & time
+ */
+void cl_VEML7700::clf_applyGainTime(GTidx_stru_t lp_gt) {
+	clv_ALSconf |= 0x0001;		/// Shut down to change config Gain & Time, it is write with new Gain & Time
+	writeGainTime(lp_gt.idxGain1, lp_gt.idxTime1);
+	wakeUp();
+}
+
+/**
+ * @brief calc raw data ALS & WHITE to LUX value
+ * @param lp_ALSdata, lp_WHITEda - raw counts, lp_gt - index of gain & time of counts
+ * @return structure AW_stru_t { (uint32_t)Lux ALS, (uint32_t)Lux WHITE }
+ */
+AW_stru_t cl_VEML7700::clf_calcAW(uint16_t lp_ALSdata, uint16_t lp_WHITEda, GTidx_stru_t lp_gt) {
+	AW_stru_t lv_AW;
+	clv_lastRaw = { lp_gt, lp_ALSdata, lp_WHITEda };
+	bool lv_corr = clv_corr && needCorr(lp_gt);
+#ifdef VEML_FIXED_POINT
+	lv_AW.als1 = lv_corr ? countsToLuxCorr(lp_ALSdata, lp_gt) : countsToLux(lp_ALSdata, lp_gt);
+	lv_AW.whi1 = countsToLux(lp_WHITEda, lp_gt);
+#ifdef DEBUG_EN
+	printf("vars -> ALS=%d, WHITE=%d, gainIdx=%d, timeIdx=%d, shift=%d, LUX=%d, WHITE=%d\n\n",
+		lp_ALSdata, lp_WHITEda, lp_gt.idxGain1, lp_gt.idxTime1,
+		clf_resolShift(lp_gt.idxGain1, lp_gt.idxTime1), lv_AW.als1, lv_AW.whi1);
+#endif
+#else
+	float lv_coef = clf_tableResol(lp_gt.idxGain1, lp_gt.idxTime1);
+	float lv_lux = lv_coef * (float)lp_ALSdata;
+	if (lv_corr) lv_lux = corrLux(lv_lux);
+	lv_AW.als1 = (uint32_t)( round(lv_lux) );
+	lv_AW.whi1 = (uint32_t)( round(lv_coef * (float)lp_WHITEda) );
+#ifdef DEBUG_EN
+	printf("vars -> ALS=%d, WHITE=%d, gainIdx=%d, timeIdx=%d, coef=%f, LUX=%d, WHITE=%d\n\n",
+		lp_ALSdata, lp_WHITEda, lp_gt.idxGain1, lp_gt.idxTime1, lv_coef, lv_AW.als1, lv_AW.whi1);
+#endif
+#endif
+	if (clv_filtMode != FILT_NONE) {
+		///	corrected lux is cut to 2e6, it is far out of range of sensor, mlux < 2^31
+		uint32_t lv_mlux = lv_corr ? ((lv_AW.als1 > 2000000ul) ? 2000000000ul : lv_AW.als1 * 1000)
+			: countsToMlux(lp_ALSdata, lp_gt);
+		lv_AW.als1 = (clf_filter(lv_mlux, clf_resolShift(lp_gt.idxGain1, lp_gt.idxTime1)) + 500) / 1000;
+	}
+	return lv_AW;
+}
+
+/**
+ * @brief filter of ALS, O(1) per sample, integer math only
+ * @param lp_mlux - ALS milli lux, lp_shift - resolution shift of gain & time of sample
+ * @return filtered ALS milli lux
+ */
+uint32_t cl_VEML7700::clf_filter(uint32_t lp_mlux, uint8_t lp_shift) {
+	///	R mlux^2 = counts^2 * 4.2^2 << 2*shift, 4.2^2 = 441 / 25
+	uint64_t lv_R = (((uint64_t)clv_filtR * 441) << (2 * lp_shift)) / 25;		///	max 2^48
+	if (!clv_filtInit) {
+		clv_filtX = (int32_t)lp_mlux;
+		clv_filtP = lv_R;
+		clv_filtInit = true;
+		return lp_mlux;
+	}
+	int32_t lv_delta = (int32_t)lp_mlux - clv_filtX;
+	if (clv_filtMode == FILT_EMA) {
+		clv_filtX += (lv_delta + (1 << (clv_filtShift - 1))) >> clv_filtShift;		///	rounded
+	}
+	else {
+		uint64_t lv_P = clv_filtP + clv_filtQ;						///	predict
+		uint32_t lv_K = (uint32_t)((lv_P << 16) / (lv_P + lv_R));	///	gain Q16, 0 .. 1, P << 16 < 2^63
+		clv_filtX += (int32_t)(((int64_t)lv_K * lv_delta + 0x8000) >> 16);
+		clv_filtP = (lv_P * (65536 - lv_K)) >> 16;
+	}
+	return (uint32_t)clv_filtX;
+}
+
+/**
+ * @brief correct nonlinearity of ALS lux by polynomial of Vishay, float math
+ * @details	lux = 6.0135e-13 x^4 - 9.3924e-9 x^3 + 8.1488e-5 x^2 + 1.0023 x, by Horner.
+ * 			It is for gain 1/8 & 1/4 only, see needCorr().
+ * @param lp_lux - linear lux (clf_tableResol * count)
+ * @return corrected lux
+ */
+float cl_VEML7700::corrLux(float lp_lux) {
+	return (((6.0135e-13f * lp_lux - 9.3924e-9f) * lp_lux + 8.1488e-5f) * lp_lux + 1.0023f) * lp_lux;
+}
+
+/**
+ * @brief calc raw ALS count to corrected lux by integer math only, no float
+ * @details	the same polynomial as corrLux(), fixed point Q28 by klux, int64
+ * @param lp_counts - raw ALS count, lp_gt - index of gain & time of count
+ * @return lux, the same as round(corrLux(clf_tableResol * count)) +- 1 for linear lux < 27 klux,
+ * 			above it polynomial grow fast and float differ more (up to 0.05 %, ~600 lux)
+ */
+uint32_t cl_VEML7700::countsToLuxCorr(uint16_t lp_counts, GTidx_stru_t lp_gt) {
+	///	coefficients for x in klux, Q28: c4 = 6.0135e-4, c3 = -9.3924e-3, c2 = 8.1488e-2, c1 = 1.0023
+	const int64_t lv_c4 = 161424, lv_c3 = -2521253, lv_c2 = 21874268, lv_c1 = 269052858;
+	///	x in klux Q16 = count * 0.0042e-3 << shift * 2^16, 4.2e-6 = 21 / 5e6, max 2^23.2
+	int64_t lv_x = ((((int64_t)lp_counts * 21) << clf_resolShift(lp_gt.idxGain1, lp_gt.idxTime1)) * 65536 + 2500000) / 5000000;
+	int64_t lv_acc = lv_c4;
+	lv_acc = ((lv_acc * lv_x) >> 16) + lv_c3;
+	lv_acc = ((lv_acc * lv_x) >> 16) + lv_c2;
+	lv_acc = ((lv_acc * lv_x) >> 16) + lv_c1;		///	max 2^38.6 at 141 klux
+	lv_acc = (lv_acc * lv_x) >> 16;					///	max 2^61.7 before shift, no overflow
+	return (uint32_t)((lv_acc * 1000 + (1 << 27)) >> 28);
+}
+
+/**
+ * @brief set gain & time and start new conversion, time of start is saved for readyAt()
+ * @param lp_idxGain index of gain (0 - 3), lp_idxTime index of time (0 - 5)
+ */
+void cl_VEML7700::startConversion(uint8_t lp_idxGain, uint8_t lp_idxTime) {
+	clf_applyGainTime({ lp_idxGain, lp_idxTime });
+}
+
+/**
+ * @brief read raw ALS & WHITE counts, it is valid after readyAt()
+ * @return GTrawAW_stru_t = { index of gain & time, raw ALS, raw WHITE }
+ */
+GTrawAW_stru_t cl_VEML7700::collect() {
+	GTrawAW_stru_t lv_raw;
+	lv_raw.gt = readGainTime();
+	lv_raw.als = readReg(cd_ALS);
+	lv_raw.whi = readReg(cd_WHITE);
+	return lv_raw;
+}
+
 /**
  * @brief read raw data from sensor and calc it to LUX value
  * @details	ALS and WHITE raw data need to be actual, after call fn wakeUp(),
- * 			should to do delay > 800 ms,
+ * 			should to do delay > 800 ms. Ranging take max 8 steps = 9 integrations.
  * @return structure AW_stru_t { (uint32_t)Lux ALS, (uint32_t)Lux WHITE } = ALS & WHATI values in lux 
  */
 AW_stru_t cl_VEML7700::readAW() {
-	AW_stru_t lv_AW =  { 0, 0 };
-	GTidx_stru_t lv_gtIdx =  { 0, 0};
-	uint8_t lv_gainIndex, lv_timeIndex;
-	uint16_t lv_ALSdata, lv_WHITEda;
+	GTidx_stru_t lv_gtIdx = readGainTime();
+	uint16_t lv_ALSdata;
+	cl_VEMLrange &lv_range = clf_range();
+	lv_range.begin();
 
-	for (uint8_t k = 0; k < 24; k++) {	/// It is possible 24 times, find gain & time value
-
-		lv_gtIdx = readGainTime();
-		lv_gainIndex = lv_gtIdx.idxGain1;
-		lv_timeIndex = lv_gtIdx.idxTime1;
-		lv_ALSdata = readReg(cd_ALS_CONF);
-		lv_WHITEda = readReg(cd_ALS_CONF);
+	for (clv_steps = 0; ; clv_steps++) {	/// max clv_maxSteps times, find gain & time value
+		lv_ALSdata = readReg(cd_ALS);
 
 #ifdef DEBUG_EN
-		printf("Attempt to measure #%d -> ALS=%d, WHITE=%d, gainIdx=%d, timeIdx=%d\n",
-			k, lv_ALSdata, lv_WHITEda, lv_gainIndex, lv_timeIndex);
+		printf("Attempt to measure #%d -> ALS=%d, gainIdx=%d, timeIdx=%d\n",
+			clv_steps, lv_ALSdata, lv_gtIdx.idxGain1, lv_gtIdx.idxTime1);
 #endif
+		///	raw ALS data is OK or reach max or min sensivity of sensor => go out of loop for
+		if ((clv_steps >= clv_maxSteps) || !lv_range.next(lv_ALSdata, lv_gtIdx)) break;
+
+		clf_applyGainTime(lv_gtIdx);
+		int32_t lv_wait = (int32_t)(readyAt() - millis());	///	Delay for sensor can update count with new Gain & Time
+		if (lv_wait > 0) delay(lv_wait);
+	}
+
+	return clf_calcAW(lv_ALSdata, readReg(cd_WHITE), lv_gtIdx);
+}
+
+/**
+ * @brief read lux within deadline, resolution can be less
+ * @details	ranging by cl_VEMLrangeLatency: only gain & time, which valid count is ready
+ * 			in rest of lp_deadlineMs, are used. Result is the best estimate reachable in time.
+ * @param lp_deadlineMs - max ms of fn, lp_precise - if not nullptr, true is written
+ * 			if raw ALS count reach window 500 .. 10000 (target precision) or there is no better
+ * 			gain & time for this light, false if ranging was cut by deadline
+ * @return structure AW_stru_t { (uint32_t)Lux ALS, (uint32_t)Lux WHITE }
+ */
+AW_stru_t cl_VEML7700::readAW(uint16_t lp_deadlineMs, bool *lp_precise) {
+	cl_VEMLrangeLatency lv_range(lp_deadlineMs);
+	cl_VEMLrange *lv_oldRange = clv_range;
+	clv_range = &lv_range;
+	AW_stru_t lv_AW = readAW();
+	clv_range = lv_oldRange;
+	if (lp_precise) *lp_precise = lv_range.met();
+	return lv_AW;
+}
+
+/**
+ * @brief continuous measurement with hysteresis, call it again and again for monitoring
+ * @details	gain & time is kept, while raw ALS count is in band of hysteresis, it is
+ * 			window 500 .. 10000 wider by setHysteresis() steps of resolution. So steady light
+ * 			cost one integration per sample. Out of band => ranging as readAW().
+ * 			Fn wait (delay) for fresh conversion after previous call.
+ * @return structure AW_stru_t { (uint32_t)Lux ALS, (uint32_t)Lux WHITE }
+ */
+AW_stru_t cl_VEML7700::readAWcont() {
+	int32_t lv_wait = (int32_t)(clv_contNext - millis());
+	if ((int32_t)(readyAt() - millis()) > lv_wait) lv_wait = (int32_t)(readyAt() - millis());
+	if (lv_wait > 0) delay(lv_wait);
 
-///		increase or decrease gain or time index to keep raw data ALS in boindes 1000 .. 10000
-		if ((lv_ALSdata >= 500) && (lv_ALSdata <= 10000)) break;	///	raw ALS data is OK, go out of loop for
-		if (lv_ALSdata < 500) {
-			if (lv_timeIndex < 2) lv_timeIndex = 2;
-			else if (lv_gainIndex < (clv_nGain - 1)) lv_gainIndex++;
-			else if (lv_timeIndex < (clv_nTime - 1)) lv_timeIndex++;
+	AW_stru_t lv_AW;
+	GTidx_stru_t lv_gtIdx = readGainTime();
+	uint16_t lv_ALSdata = readReg(cd_ALS);
+	uint32_t lv_high = (uint32_t)cd_ALS_HIGH << clv_hystShift;
+	if ((lv_ALSdata >= (cd_ALS_LOW >> clv_hystShift)) && (lv_ALSdata <= lv_high) && (lv_ALSdata != 0xFFFF)) {
+		clv_steps = 0;
+		lv_AW = clf_calcAW(lv_ALSdata, readReg(cd_WHITE), lv_gtIdx);
+	}
+	else lv_AW = readAW();		///	out of band, the last count is valid, so readAW() start without wait
+	clv_contNext = millis() + clf_readyMs(readGainTime().idxTime1);
+	return lv_AW;
+}
+
+/**
+ * @brief N samples with one ranging: readAW(), then integrations with the same gain & time
+ * @details	the last count of ranging is the 1st sample, so fn take ranging + (N - 1) integrations.
+ * 			If ranging take no step, its count can be old conversion, so it is skipped and
+ * 			the 1st sample is the next conversion.
+ * 			Statistics of ALS are calc by Welford, counts in fixed point Q8, integer math only.
+ * 			Correction of nonlinearity (setCorrection()) is applied to mean ALS lux only.
+ * @param lp_n - number of samples 1 .. 255
+ * @return structure AWstat_stru_t with mean lux, variance, min & max
+ */
+AWstat_stru_t cl_VEML7700::readAWavg(uint8_t lp_n) {
+	if (lp_n == 0) lp_n = 1;
+	readAW();							///	ranging, gain & time is locked after it
+	GTrawAW_stru_t lv_raw = clv_lastRaw;
+	uint8_t lv_steps = clv_steps;
+	if (lv_steps == 0) {				///	count was in register before call, take fresh one
+		delay(clf_readyMs(lv_raw.gt.idxTime1));
+		lv_raw.als = readReg(cd_ALS);
+		lv_raw.whi = readReg(cd_WHITE);
+	}
+	uint8_t lv_shift = clf_resolShift(lv_raw.gt.idxGain1, lv_raw.gt.idxTime1);
+	int64_t lv_mean = 0, lv_M2 = 0;		///	Welford, counts Q8
+	uint32_t lv_sumWhite = 0;
+	uint16_t lv_min = 0xFFFF, lv_max = 0;
+
+	for (uint8_t i = 1; ; i++) {
+		int64_t lv_x = (int64_t)lv_raw.als << 8;
+		int64_t lv_delta = lv_x - lv_mean;
+		lv_mean += lv_delta / i;
+		lv_M2 += (lv_delta * (lv_x - lv_mean)) >> 8;	///	max 2^48 per sample, no overflow
+		lv_sumWhite += lv_raw.whi;
+		if (lv_raw.als < lv_min) lv_min = lv_raw.als;
+		if (lv_raw.als > lv_max) lv_max = lv_raw.als;
+		if (i >= lp_n) break;
+
+		delay(clf_readyMs(lv_raw.gt.idxTime1));		///	the next conversion is complete
+		lv_raw.als = readReg(cd_ALS);
+		lv_raw.whi = readReg(cd_WHITE);
+	}
+
+	AWstat_stru_t lv_stat;
+	lv_stat.gt = lv_raw.gt;
+	lv_stat.n = lp_n;
+	///	mlux = counts * 4.2 << shift, 4.2 = 21 / 5, mean is Q8
+	lv_stat.meanMlux = (uint32_t)(((((uint64_t)lv_mean * 21) << lv_shift) + 640) / 1280);
+	///	var mlux^2 = var counts^2 * 4.2^2 << 2*shift, 4.2^2 = 441 / 25, Q8 => / 6400,
+	///	multiply before divide keep small variance, max 2^47 before shift, 2^53 after
+	uint64_t lv_var = (lp_n > 1) ? (uint64_t)lv_M2 / (lp_n - 1) : 0;
+	lv_stat.varMlux2 = ((lv_var * 441) / 6400) << (2 * lv_shift);
+	lv_stat.minLux = countsToLux(lv_min, lv_raw.gt);
+	lv_stat.maxLux = countsToLux(lv_max, lv_raw.gt);
+	lv_stat.aw.als1 = (clv_corr && needCorr(lv_raw.gt))
+		? countsToLuxCorr((uint16_t)((lv_mean + 128) >> 8), lv_raw.gt) : (lv_stat.meanMlux + 500) / 1000;
+	lv_stat.aw.whi1 = countsToLux((uint16_t)((lv_sumWhite + lp_n / 2) / lp_n), lv_raw.gt);
+	clv_lastRaw = lv_raw;
+	clv_steps = lv_steps;
+	return lv_stat;
+}
+
+/**
+ * @brief merge counts of short & long exposure to lux, integer math only
+ * @param lp_short, lp_long - raw counts, lp_corr - correct nonlinearity of exposure used alone,
+ * 			lp_used - exposures which give lux are written, see hdrExp_t
+ * @return lux
+ */
+uint32_t cl_VEML7700::clf_mergeHDR(uint16_t lp_short, uint16_t lp_long, bool lp_corr, uint8_t &lp_used) {
+	bool lv_satShort = lp_short >= clv_hdrSat;
+	bool lv_satLong = lp_long >= clv_hdrSat;
+	if (lv_satShort || lv_satLong) {
+		GTidx_stru_t lv_gt = (lv_satShort && !lv_satLong) ? clv_hdrLong : clv_hdrShort;
+		uint16_t lv_counts = (lv_satShort && !lv_satLong) ? lp_long : lp_short;
+		lp_used = (lv_satShort && lv_satLong) ? HDR_NONE : ((lv_satShort) ? HDR_LONG : HDR_SHORT);
+		return (lp_corr && needCorr(lv_gt)) ? countsToLuxCorr(lv_counts, lv_gt) : countsToLux(lv_counts, lv_gt);
+	}
+	///	lux = 0.0042 * (c_s + c_l) * 2^(s_s + s_l) / (2^s_s + 2^s_l), 0.0042 = 21 / 5000
+	uint8_t lv_shiftS = clf_resolShift(clv_hdrShort.idxGain1, clv_hdrShort.idxTime1);
+	uint8_t lv_shiftL = clf_resolShift(clv_hdrLong.idxGain1, clv_hdrLong.idxTime1);
+	uint64_t lv_num = (((uint64_t)lp_short + lp_long) * 21) << (lv_shiftS + lv_shiftL);	///	max 2^45
+	uint64_t lv_den = 5000ull * ((1ul << lv_shiftS) + (1ul << lv_shiftL));
+	lp_used = HDR_BOTH;
+	return (uint32_t)((lv_num + lv_den / 2) / lv_den);
+}
+
+/**
+ * @brief HDR measurement: short and long exposure one after other, merged to one lux
+ * @details	there is no ranging, fn always take 2 fresh integrations (default 25 + 200 ms), so it do not
+ * 			chase fast changing light. Order of exposures alternate, the last one of previous
+ * 			call is the first one, only one change of gain & time per call. The first exposure
+ * 			wait for conversion, which is finished after previous call read it, so count is not stale.
+ * 			Counts are merged by noise (Poisson): lux = (c_s + c_l) / (1/r_s + 1/r_l), r - lux per count,
+ * 			saturated exposure (count >= 0xF000) is ignored.
+ * 			Correction of nonlinearity (setCorrection()) is applied to exposure, which is used alone.
+ * @param lp_used - if not nullptr, exposures which give ALS lux are written, see hdrExp_t
+ * @return structure AW_stru_t { (uint32_t)Lux ALS, (uint32_t)Lux WHITE }
+ */
+AW_stru_t cl_VEML7700::readHDR(hdrExp_t *lp_used) {
+	GTrawAW_stru_t lv_raw[2];				///	0 - short, 1 - long exposure
+	GTidx_stru_t lv_gt = readGainTime();
+	bool lv_longFirst = (lv_gt.idxGain1 == clv_hdrLong.idxGain1) && (lv_gt.idxTime1 == clv_hdrLong.idxTime1);
+
+	for (uint8_t i = 0; i < 2; i++) {
+		uint8_t lv_exp = lv_longFirst ? 1 - i : i;
+		GTidx_stru_t lv_expGT = lv_exp ? clv_hdrLong : clv_hdrShort;
+		lv_gt = readGainTime();
+		int32_t lv_wait;
+		if ((lv_gt.idxGain1 != lv_expGT.idxGain1) || (lv_gt.idxTime1 != lv_expGT.idxTime1)) {
+			clf_applyGainTime(lv_expGT);				///	restart conversion, readyAt() is fresh count
+			lv_wait = (int32_t)(readyAt() - millis());
 		}
-		else if (lv_ALSdata > 10000) {
-			if (lv_timeIndex > 2)	lv_timeIndex--;
-			else if (lv_gainIndex != 0)	lv_gainIndex--;
-			else if (lv_timeIndex != 0) lv_timeIndex--;
+		else {											///	the same exposure again, wait for conversion after last read
+			lv_wait = (int32_t)(readyAt() - millis());
+			if ((int32_t)(clv_hdrNext - millis()) > lv_wait) lv_wait = (int32_t)(clv_hdrNext - millis());
 		}
+		if (lv_wait > 0) delay(lv_wait);
+		lv_raw[lv_exp] = collect();
+		clv_hdrNext = millis() + clf_readyMs(lv_expGT.idxTime1);
+	}
 
-		sleep();		/// Shut down to change config Gain & Time
-		writeGainTime(lv_gainIndex, lv_timeIndex);
-		wakeUp();
-		delay(clv_ALSdelay[lv_timeIndex] + 100);	///	Delay for sensor can update count with new Gain & Time
-		// delay(850);	// if something not good work
+	AW_stru_t lv_AW;
+	uint8_t lv_used, lv_usedWhite;
+	lv_AW.als1 = clf_mergeHDR(lv_raw[0].als, lv_raw[1].als, clv_corr, lv_used);
+	lv_AW.whi1 = clf_mergeHDR(lv_raw[0].whi, lv_raw[1].whi, false, lv_usedWhite);
+	clv_lastRaw = lv_raw[(lv_used & HDR_LONG) ? 1 : 0];
+	clv_steps = 0;
+	if (lp_used) *lp_used = (hdrExp_t)lv_used;
+	return lv_AW;
+}
 
-		///	if reach max or min sensivity of sensor => go out of loop for, no more :-)
-		if ( ( lv_gainIndex == (clv_nGain-1) ) && ( lv_timeIndex == (clv_nTime-1) ) )	break;
-		if ( (lv_gainIndex == 0) && (lv_timeIndex == 0) )	break;
-	}
+/**
+ * @brief start non-blocking measurement, the same ranging of gain & time as readAW()
+ * @details	fn return at once, then call poll() in main loop until it return MEAS_READY.
+ * 			Between poll() calls i2c bus and CPU are free for other work.
+ */
+void cl_VEML7700::beginMeasure() {
+	clv_measGT = readGainTime();
+	clf_range().begin();
+	clv_steps = 0;
+	clv_measDeadline = readyAt();		///	counts of current gain & time are valid after it
+	clv_measState = MEAS_PENDING;
+}
 
-	lv_ALSdata = readReg(cd_ALS);
-	lv_WHITEda = readReg(cd_WHITE);
-	float lv_coef = clv_tableResol[lv_gainIndex][lv_timeIndex];
-	lv_AW.als1 = (uint32_t)( round(lv_coef * (float)lv_ALSdata) );
-	lv_AW.whi1 = (uint32_t)( round(lv_coef * (float)lv_WHITEda) );
+/**
+ * @brief do next step of non-blocking measurement, if time of integration is over
+ * @details	fn never call delay(), deadlines are calculated by millis() and integration time.
+ * @return MEAS_PENDING - sensor is integrating, MEAS_READY - result() is valid,
+ * 			MEAS_IDLE - beginMeasure() was not called.
+ */
+measSt_t cl_VEML7700::poll() {
+	if (clv_measState != MEAS_PENDING) return clv_measState;
+	if ((int32_t)(millis() - clv_measDeadline) < 0) return MEAS_PENDING;	///	safe for millis() overflow
+
+	uint16_t lv_ALSdata = readReg(cd_ALS);
 #ifdef DEBUG_EN
-	printf("vars -> ALS=%d, WHITE=%d, gainIdx=%d, timeIdx=%d, coef=%f, LUX=%d, WHITE=%d\n\n",
-		lv_ALSdata, lv_WHITEda, lv_gainIndex, lv_timeIndex, lv_coef, lv_AW.als1, lv_AW.whi1);
+	printf("Poll step #%d -> ALS=%d, gainIdx=%d, timeIdx=%d\n",
+		clv_steps, lv_ALSdata, clv_measGT.idxGain1, clv_measGT.idxTime1);
 #endif
-	return lv_AW;
+	if ( (clv_steps >= clv_maxSteps) || !clf_range().next(lv_ALSdata, clv_measGT) ) {
+		clv_measAW = clf_calcAW(lv_ALSdata, readReg(cd_WHITE), clv_measGT);
+		clv_measState = MEAS_READY;
+		return MEAS_READY;
+	}
+
+	clf_applyGainTime(clv_measGT);
+	clv_measDeadline = readyAt();
+	clv_steps++;
+	return MEAS_PENDING;
 }
 
-//============================================================================================
\ No newline at end of file
+//============================================================================================
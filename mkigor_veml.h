@@ -29,18 +29,31 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include <mkigor_veml_bus.h>
 
 #ifndef mkigor_veml_h
 #define mkigor_veml_h
 
 /// Command code of registers
 #define cd_ALS_CONF 0
+#define cd_ALS_WH	1
+#define cd_ALS_WL	2
 #define cd_PSM		3
 #define cd_ALS		4
 #define cd_WHITE	5
+#define cd_ALS_INT	6
 #define cd_ID		7
 
+/// Window of raw ALS count for ranging, datasheet & step policy
+#define cd_ALS_LOW		500
+#define cd_ALS_HIGH		10000
+
+/// Flags of ALS_INT register, return of readInt()
+#define cd_INT_TH_LOW	0x8000
+#define cd_INT_TH_HIGH	0x4000
+
 // #define DEBUG_EN		/// Uncomment to print add info
+// #define VEML_FIXED_POINT	/// Uncomment to calc lux without float, for MCU without FPU
 
 struct AW_stru_t	{
 	uint32_t als1;
@@ -52,28 +65,197 @@ struct GTidx_stru_t	{
 	uint8_t idxTime1;
 };
 
+struct GTrawAW_stru_t	{
+	GTidx_stru_t gt;	///	index of gain & time of counts
+	uint16_t als;		///	raw ALS count
+	uint16_t whi;		///	raw WHITE count
+};
+
+struct AWstat_stru_t	{
+	AW_stru_t		aw;			///	mean lux of ALS & WHITE
+	uint32_t		meanMlux;	///	mean of ALS, milli lux
+	uint64_t		varMlux2;	///	variance of ALS (unbiased), milli lux ^ 2
+	uint32_t		minLux;		///	min of ALS, lux
+	uint32_t		maxLux;		///	max of ALS, lux
+	GTidx_stru_t	gt;			///	index of gain & time of all samples
+	uint8_t			n;			///	number of samples
+};
+
+struct gainDesc_stru_t	{
+	uint8_t code;		///	ALS_GAIN <12:11> of ALS_CONF
+	uint8_t shift;		///	resolution shift
+	uint8_t nonlin;		///	1 - count is nonlinear, lux need correction by polynomial
+};
+
+struct timeDesc_stru_t	{
+	uint8_t code;		///	ALS_IT <9:6> of ALS_CONF
+	uint8_t shift;		///	resolution shift
+	uint16_t ms;		///	integration time, ms
+};
+
+/// State of non-blocking measurement, return of poll()
+enum measSt_t : uint8_t {
+	MEAS_IDLE = 0,		///	beginMeasure() was not called
+	MEAS_PENDING,		///	sensor is integrating, call poll() later
+	MEAS_READY			///	result() is valid
+};
+
+/// Mode of ranging gain & time in readAW() and poll(), built-in policies of mkigor_veml_range.h
+enum rangeMode_t : uint8_t {
+	RANGE_STEP = 0,		///	change gain or time by one index each integration
+	RANGE_PREDICT		///	calc lux from one reading and go straight to proper gain & time
+};
+
+/// Filter of ALS lux in readAW(), readAWcont(), poll(), psmSample()
+enum filt_t : uint8_t {
+	FILT_NONE = 0,		///	no filter
+	FILT_EMA,			///	exponential moving average, alpha = 1 / 2^k
+	FILT_KALMAN			///	scalar Kalman filter, noise of measurement scale with resolution
+};
+
+/// Exposures of HDR measurement readHDR(), which give result, bits
+enum hdrExp_t : uint8_t {
+	HDR_NONE = 0,		///	both exposures are saturated, result is low bound by short exposure
+	HDR_SHORT = 1,		///	short exposure, long one is saturated
+	HDR_LONG = 2,		///	long exposure, short one is saturated (light is changing fast)
+	HDR_BOTH = 3		///	both exposures are merged
+};
+
+/**
+ * @brief	Policy (strategy) of ranging gain & time for readAW(), poll() and others.
+ * 			Built-in policies are in mkigor_veml_range.h, own policy is a child of this class.
+ */
+class cl_VEMLrange {
+public:
+virtual ~cl_VEMLrange() {};
+
+/**
+ * @brief it is called once before ranging, for policy with state
+ */
+virtual void begin() {};
+
+/**
+ * @brief decide next gain & time by raw ALS count of current gain & time
+ * @param lp_ALSdata - raw ALS count, lp_gt - current gain & time index, policy change it
+ * @return false - stop ranging and take this count, true - measure again with new lp_gt
+ */
+virtual bool next(uint16_t lp_ALSdata, GTidx_stru_t &lp_gt) = 0;
+};
+
 //============================================================================================
 
 class cl_VEML7700 {
 private:
 	uint8_t clv_i2cAddr;
-	/// Constant vars
+	cl_VEMLwire		clv_wireBus;		///	default adapter, used if bus is not given to constructor
+	cl_VEMLbus		*clv_bus;			///	bus given to constructor, nullptr - clv_wireBus, so copy of object is safe
+	/// Constant tables, static constexpr => one copy in flash for all instances
 	const static uint8_t	clv_nGain = 4;
 	const static uint8_t	clv_nTime = 6;
-	const uint8_t	clv_ALSgain[clv_nGain] = { 2, 3, 0, 1};	///	1/8, 1/4, 1. 2
-	const uint8_t	clv_ALStime[clv_nTime] = { 0x0C, 0x08, 0, 0x01, 0x02, 0x03};
-	const uint16_t	clv_ALSdelay[clv_nTime] = { 25, 50, 100,  200,  400,  800};
-	const float 	clv_tableResol[clv_nGain] [clv_nTime] = {
-			{2.1504, 1.0752, 0.5376, 0.2688, 0.1344, 0.0672},
-			{1.0752, 0.5376, 0.2688, 0.1344, 0.0672, 0.0336},
-			{0.2688, 0.1344, 0.0672, 0.0336, 0.0168, 0.0084},
-			{0.1344, 0.0672, 0.0336, 0.0168, 0.0084, 0.0042} };
+	/// Descriptor of gain & time: code in ALS_CONF, resolution shift, integration time.
+	/// Resolution is clv_resolBase (micro lux per count) << (shift of gain + shift of time)
+	const static uint16_t	clv_resolBase = 4200;	///	gain x2, time 800 ms = 0.0042 lux/count
+	static constexpr gainDesc_stru_t clv_gainDesc[clv_nGain] = {
+			{2, 4, 1}, {3, 3, 1}, {0, 1, 0}, {1, 0, 0} };		///	1/8, 1/4, 1. 2
+	static constexpr timeDesc_stru_t clv_timeDesc[clv_nTime] = {
+			{0x0C, 5, 25}, {0x08, 4, 50}, {0, 3, 100}, {0x01, 2, 200}, {0x02, 1, 400}, {0x03, 0, 800} };
+
+	/// shift of resolution for index of gain & time
+	static constexpr uint8_t clf_resolShift(uint8_t lp_idxGain, uint8_t lp_idxTime) {
+		return clv_gainDesc[lp_idxGain].shift + clv_timeDesc[lp_idxTime].shift;
+	};
+	/// resolution lux per count for index of gain & time, table 2.1504 .. 0.0042
+	static constexpr float clf_tableResol(uint8_t lp_idxGain, uint8_t lp_idxTime) {
+		return (float)((uint32_t)clv_resolBase << clf_resolShift(lp_idxGain, lp_idxTime)) / 1000000.0f;
+	};
+
+	/// Shadow copy of registers, filled by check(), i2c is used only to write them
+	uint16_t		clv_ALSconf = 0x0001;		///	power on default: shut down
+	uint16_t		clv_PSM = 0;
+	/// Thresholds of interrupt in lux, counts are recalculated if gain & time is changed
+	uint32_t		clv_thLow = 0;
+	uint32_t		clv_thHigh = 0;
+	/// Power saving mode: supply current, uA, by datasheet, rows time 100 .. 800 ms, columns PSM 1 .. 4
+	static constexpr uint8_t clv_psmIdd[4] [4] = {
+			{ 8,  5,  3, 2},
+			{13,  8,  5, 3},
+			{20, 13,  8, 5},
+			{28, 20, 13, 8} };
+	const static uint8_t	clv_activeIdd = 45;		///	uA, PSM is off
+	const static uint8_t	clv_settleMs = 3;		///	ms, wake up 2.5 ms by datasheet
+	uint32_t		clv_convStart = 0;			///	millis() when sensor start count with current gain & time
+	/// ms from start of counting to valid count: time + 1/16 time for tolerance of oscillator + wake up
+	static constexpr uint16_t clf_readyMs(uint8_t lp_idxTime) {
+		return clv_timeDesc[lp_idxTime].ms + clv_timeDesc[lp_idxTime].ms / 16 + clv_settleMs;
+	};
+	GTidx_stru_t	clv_psmGT = { 0, 0 };
+	uint32_t		clv_psmNext = 0;			///	millis() of next fresh conversion
+	/// Max ranging steps. Each step change sensivity max x4, window 500 .. 10000 is x20,
+	/// so ranging never turn back and walk max the longest way {3, 5} -> {0, 0} = 8 steps.
+	/// Predict jump land in window or go the same way, so 8 steps is bound for both modes.
+	/// Other policies are cut by this bound too.
+	const static uint8_t	clv_maxSteps = 8;
+	uint8_t			clv_steps = 0;				///	steps of last readAW() or poll()
+	cl_VEMLrange	*clv_range = nullptr;		///	policy of ranging, nullptr - built-in RANGE_STEP
+	/// Continuous mode: band of hysteresis is window cd_ALS_LOW .. cd_ALS_HIGH wider by
+	/// clv_hystShift steps of resolution (each step of clf_tableResol is x2)
+	uint8_t			clv_hystShift = 1;
+	uint32_t		clv_contNext = 0;			///	millis() of next fresh conversion
+	bool			clv_corr = false;			///	correction of nonlinearity of ALS lux is on
+	/// Filter of ALS, fixed point, state in milli lux
+	filt_t			clv_filtMode = FILT_NONE;
+	bool			clv_filtInit = false;		///	state is valid, false - next sample init it
+	uint8_t			clv_filtShift = 2;			///	EMA: alpha = 1 / 2^clv_filtShift
+	uint32_t		clv_filtQ = 0;				///	Kalman: noise of process, mlux^2 per sample
+	uint8_t			clv_filtR = 1;				///	Kalman: noise of measurement, counts^2
+	int32_t			clv_filtX = 0;				///	filtered ALS, mlux
+	uint64_t		clv_filtP = 0;				///	Kalman: variance of clv_filtX, mlux^2
+	/// HDR: short 1/8 25 ms (2.1504 lux/count, up to 140 klux), long x1 200 ms (0.0336 lux/count)
+	GTidx_stru_t	clv_hdrShort = { 0, 0 };
+	GTidx_stru_t	clv_hdrLong = { 2, 3 };
+	const static uint16_t	clv_hdrSat = 0xF000;	///	count is saturated (or near) for HDR merge
+	uint32_t		clv_hdrNext = 0;			///	millis() of conversion after the last read of readHDR()
+
+	/// State of non-blocking measurement
+	measSt_t		clv_measState = MEAS_IDLE;
+	GTidx_stru_t	clv_measGT = { 0, 0 };
+	uint32_t		clv_measDeadline = 0;		///	millis() when counts with new gain & time are valid
+	AW_stru_t		clv_measAW = { 0, 0 };
+	GTrawAW_stru_t	clv_lastRaw = { { 0, 0 }, 0, 0 };	///	raw counts of last result
+
+	void clf_writeConf(uint16_t lp_ALSconf);
+	void clf_writeThresholds();
+	cl_VEMLrange &clf_range();
+	void clf_applyGainTime(GTidx_stru_t lp_gt);
+	AW_stru_t clf_calcAW(uint16_t lp_ALSdata, uint16_t lp_WHITEda, GTidx_stru_t lp_gt);
+	uint32_t clf_filter(uint32_t lp_mlux, uint8_t lp_shift);
+	/// bus of sensor: own adapter of this object or bus given to constructor
+	cl_VEMLbus &clf_bus() { return clv_bus ? *clv_bus : clv_wireBus; };
+	uint32_t clf_mergeHDR(uint16_t lp_short, uint16_t lp_long, bool lp_corr, uint8_t &lp_used);
 
 public:
-	cl_VEML7700() {					/// default class constructor
+	/// default class constructor, sensor is on Arduino bus lp_wire (Wire by default)
+	cl_VEML7700(TwoWire &lp_wire = Wire) : clv_wireBus(lp_wire), clv_bus(nullptr) {
+		clv_i2cAddr = 0x10;			/// default VEML7700 i2c address
+	};
+
+	/// class constructor, sensor is on any bus, see mkigor_veml_bus.h
+	cl_VEML7700(cl_VEMLbus &lp_bus) : clv_wireBus(Wire), clv_bus(&lp_bus) {
 		clv_i2cAddr = 0x10;			/// default VEML7700 i2c address
 	};
 
+/// number of gain & time settings, index of gain 0 .. nGain() - 1, index of time 0 .. nTime() - 1
+static constexpr uint8_t nGain() { return clv_nGain; };
+static constexpr uint8_t nTime() { return clv_nTime; };
+
+/// resolution = 0.0042 lux/count << resolShift(), 0 for gain x2 & 800 ms, 9 for gain 1/8 & 25 ms
+static constexpr uint8_t resolShift(uint8_t lp_idxGain, uint8_t lp_idxTime) {
+	return clf_resolShift(lp_idxGain, lp_idxTime);
+};
+
+/// ms from start of conversion to valid count for index of time, see readyAt()
+static constexpr uint16_t readyMs(uint8_t lp_idxTime) { return clf_readyMs(lp_idxTime); };
+
 /**
  * @brief Read 16 bit register of command code = command.
  * @param command - command code of 16 bit register
@@ -95,6 +277,14 @@ void writeReg(uint8_t command, uint16_t data);
  */
 uint16_t check(uint8_t lp_addr = 0x10);
 
+/**
+ * @brief Read ALS_CONF & PSM registers from sensor to shadow copy in class.
+ * @details	Methods sleep(), wakeUp(), writeGainTime(), readGainTime() use only the copy and
+ * 			do not read sensor. Call it after i2c bus error or if someone else write to sensor.
+ * @return true if OK, false if i2c error, shadow copy is not changed then
+ */
+bool resync();
+
 /**
  * @brief sent sensor to shut down, min power.
  * @details	all config settings are save,
@@ -116,20 +306,323 @@ void wakeUp();
 void writeGainTime(uint8_t lp_idxGain, uint8_t lp_idxTime);
 
 /**
- * @brief read value of gain & time, read 16 bit raw data ALS, WHITE
+ * @brief read value of gain & time from shadow copy of ALS_CONF, no i2c transaction
  * 
- * @return GTrawAW_stru_t = {uint8_t GT, uint16_t ALS, uint16_t WHITE}
+ * @return GTidx_stru_t = {uint8_t index of gain, uint8_t index of time}
  */
 GTidx_stru_t readGainTime();
 
+/**
+ * @brief calc raw count to milli lux by integer math only, no float
+ * @param lp_counts - raw ALS or WHITE count, lp_gt - index of gain & time of count
+ * @return milli lux, the same as clf_tableResol * count * 1000 rounded
+ */
+static uint32_t countsToMlux(uint16_t lp_counts, GTidx_stru_t lp_gt) {
+	///	4.2 mlux = 21/5, (65535 * 21) << 9 < 2^31, no overflow
+	return ((((uint32_t)lp_counts * 21) << clf_resolShift(lp_gt.idxGain1, lp_gt.idxTime1)) + 2) / 5;
+};
+
+/**
+ * @brief calc raw count to lux by integer math only, no float
+ * @param lp_counts - raw ALS or WHITE count, lp_gt - index of gain & time of count
+ * @return lux, the same as round(clf_tableResol * count)
+ */
+static uint32_t countsToLux(uint16_t lp_counts, GTidx_stru_t lp_gt) {
+	return ((((uint32_t)lp_counts * 21) << clf_resolShift(lp_gt.idxGain1, lp_gt.idxTime1)) + 2500) / 5000;
+};
+
+/**
+ * @brief correct nonlinearity of ALS lux by polynomial of Vishay, float math
+ * @details	lux = 6.0135e-13 x^4 - 9.3924e-9 x^3 + 8.1488e-5 x^2 + 1.0023 x, by Horner.
+ * 			It is for gain 1/8 & 1/4 only, see needCorr().
+ * @param lp_lux - linear lux (clf_tableResol * count)
+ * @return corrected lux
+ */
+static float corrLux(float lp_lux);
+
+/**
+ * @brief calc raw ALS count to corrected lux by integer math only, no float
+ * @details	the same polynomial as corrLux(), fixed point Q28 by klux, int64
+ * @param lp_counts - raw ALS count, lp_gt - index of gain & time of count
+ * @return lux, the same as round(corrLux(clf_tableResol * count)) +- 1 for linear lux < 27 klux,
+ * 			above it polynomial grow fast and float differ more (up to 0.05 %, ~600 lux)
+ */
+static uint32_t countsToLuxCorr(uint16_t lp_counts, GTidx_stru_t lp_gt);
+
+/// true if count of gain lp_gt need correction of nonlinearity (gain 1/8 & 1/4)
+static constexpr bool needCorr(GTidx_stru_t lp_gt) { return clv_gainDesc[lp_gt.idxGain1].nonlin; };
+
+/**
+ * @brief switch on / off correction of nonlinearity of ALS lux (WHITE is kept linear)
+ * @details	correction is applied only for gain 1/8 & 1/4, other gains are linear and cost nothing.
+ * 			Thresholds of setThresholds() are linear lux.
+ */
+void setCorrection(bool lp_on) { clv_corr = lp_on; };
+
+/// true if correction of nonlinearity is on
+bool correction() { return clv_corr; };
+
+/**
+ * @brief switch off filter of ALS lux
+ */
+void setFilterOff() { clv_filtMode = FILT_NONE; };
+
+/**
+ * @brief filter ALS lux by exponential moving average, y += (x - y) / 2^k, fixed point mlux
+ * @param lp_k - alpha = 1 / 2^k, 1 .. 8, bigger k - smoother and slower
+ */
+void setFilterEMA(uint8_t lp_k) {
+	clv_filtShift = (lp_k < 1) ? 1 : ((lp_k > 8) ? 8 : lp_k);
+	clv_filtMode = FILT_EMA;
+	clv_filtInit = false;
+};
+
+/**
+ * @brief filter ALS lux by scalar Kalman filter (random walk), fixed point mlux
+ * @details	noise of measurement R = lp_rCounts * resolution^2, so it follow gain & time of ranging:
+ * 			sensitive gain & time (small lux per count) is trusted more.
+ * @param lp_qMlux2 - noise of process, variance of light change per sample, mlux^2,
+ * 			lp_rCounts - noise of measurement, counts^2, 1 .. 255, 1 by default
+ */
+void setFilterKalman(uint32_t lp_qMlux2, uint8_t lp_rCounts = 1) {
+	clv_filtQ = lp_qMlux2;
+	clv_filtR = lp_rCounts ? lp_rCounts : 1;
+	clv_filtMode = FILT_KALMAN;
+	clv_filtInit = false;
+};
+
+/// forget state of filter, the next sample init it, call it after known step of light
+void resetFilter() { clv_filtInit = false; };
+
+/// mode of filter of ALS lux, FILT_NONE - off
+filt_t filterMode() { return clv_filtMode; };
+
+/**
+ * @brief calc lux to raw count by integer math, reverse of countsToLux()
+ * @param lp_lux - lux, lp_gt - index of gain & time
+ * @return raw count, 65535 if lux is more than sensor can count with this gain & time
+ */
+static uint16_t luxToCounts(uint32_t lp_lux, GTidx_stru_t lp_gt) {
+	if (lp_lux > 140000ul) lp_lux = 140000ul;		///	140000 * 5000 < 2^32, more is saturation anyway
+	uint32_t lv_counts = (lp_lux * 5000 + (21ul << clf_resolShift(lp_gt.idxGain1, lp_gt.idxTime1)) / 2)
+		/ (21ul << clf_resolShift(lp_gt.idxGain1, lp_gt.idxTime1));
+	return (lv_counts > 0xFFFF) ? 0xFFFF : (uint16_t)lv_counts;
+};
+
+/**
+ * @brief arm interrupt, when ALS is out of band lp_luxLow .. lp_luxHigh
+ * @details	lux is calc to raw counts of current gain & time and write to ALS_WL, ALS_WH,
+ * 			if gain & time is changed by ranging, thresholds are written again.
+ * 			Flag of interrupt is read by readInt(), pin INT of sensor go low.
+ * @param lp_luxLow, lp_luxHigh - band in lux,
+ * 			lp_pers - ALS_PERS code 0 - 3 = number of conversions out of band 1, 2, 4, 8 to set flag
+ */
+void setThresholds(uint32_t lp_luxLow, uint32_t lp_luxHigh, uint8_t lp_pers = 0);
+
+/**
+ * @brief arm interrupt, when raw ALS count of current gain & time is out of band lp_low .. lp_high
+ * @details	counts are written to ALS_WL, ALS_WH as they are, so band is exact to one count.
+ * 			If gain & time is changed by ranging, thresholds are written again from linear lux
+ * 			of these counts.
+ * @param lp_low, lp_high - band in raw counts,
+ * 			lp_pers - ALS_PERS code 0 - 3 = number of conversions out of band 1, 2, 4, 8 to set flag
+ */
+void setThresholdCounts(uint16_t lp_low, uint16_t lp_high, uint8_t lp_pers = 0);
+
+/**
+ * @brief disable interrupt, clear ALS_INT_EN
+ */
+void disableInt();
+
+/**
+ * @brief read and clear flags of interrupt, sensor clear ALS_INT register by read
+ * @return cd_INT_TH_LOW | cd_INT_TH_HIGH or 0 if light was in band
+ */
+uint16_t readInt();
+
+/**
+ * @brief start periodic sampling in power saving mode (PSM)
+ * @details	sensor count lp_idxTime, then wait 500, 1000, 2000 or 4000 ms by PSM mode and so on.
+ * 			Take samples by psmSample(), it read sensor only if fresh conversion is due.
+ * @param lp_mode - PSM mode 1 - 4 (0 - PSM off, continuous counting),
+ * 			lp_idxGain index of gain (0 - 3), lp_idxTime index of time (0 - 5)
+ */
+void startPSM(uint8_t lp_mode, uint8_t lp_idxGain, uint8_t lp_idxTime);
+
+/**
+ * @brief stop power saving mode, sensor count continuous
+ */
+void stopPSM();
+
+/**
+ * @brief refresh period of sensor with current PSM mode & time
+ * @return ms between fresh conversions = time + wait time of PSM
+ */
+uint16_t psmPeriod();
+
+/**
+ * @brief supply current of sensor with current PSM mode & time by datasheet
+ * @details	datasheet has table for time 100 .. 800 ms, for 25 & 50 ms value of 100 ms is returned
+ * @return uA
+ */
+uint8_t psmCurrent();
+
+/**
+ * @brief take sample in PSM, read ALS & WHITE only if fresh conversion is due
+ * @param lp_AW - result in lux, is changed only if fn return true
+ * @return true - new sample is in lp_AW, false - no fresh conversion yet, no i2c transaction
+ */
+bool psmSample(AW_stru_t &lp_AW);
+
+/**
+ * @brief set mode of ranging gain & time for readAW() and poll()
+ * @param lp_mode - RANGE_STEP (default) one index per integration,
+ * 			RANGE_PREDICT jump to proper gain & time by clf_tableResol, usually 1 - 2 integrations.
+ * 			If raw count is 0 or 65535 (saturation) RANGE_PREDICT do one step as RANGE_STEP.
+ */
+void setRangeMode(rangeMode_t lp_mode);
+
+/**
+ * @brief set own policy of ranging, see mkigor_veml_range.h, object must live while it is used
+ * @param lp_range - policy, for example cl_VEMLrangeLatency or cl_VEMLrangeMaxRes
+ */
+void setRangePolicy(cl_VEMLrange &lp_range) { clv_range = &lp_range; };
+
+/**
+ * @brief set gain & time and start new conversion, time of start is saved for readyAt()
+ * @param lp_idxGain index of gain (0 - 3), lp_idxTime index of time (0 - 5)
+ */
+void startConversion(uint8_t lp_idxGain, uint8_t lp_idxTime);
+
+/**
+ * @brief restart conversion with current gain & time
+ */
+void startConversion() { clf_applyGainTime(readGainTime()); };
+
+/**
+ * @brief the earliest millis(), when count of current gain & time is valid
+ * @details	= start of conversion + integration time + margin (oscillator tolerance, wake up 2.5 ms).
+ * 			CPU can sleep until it, then call collect().
+ */
+uint32_t readyAt() { return clv_convStart + clf_readyMs(readGainTime().idxTime1); };
+
+/**
+ * @brief read raw ALS & WHITE counts, it is valid after readyAt()
+ * @return GTrawAW_stru_t = { index of gain & time, raw ALS, raw WHITE }
+ */
+GTrawAW_stru_t collect();
+
 /**
  * @brief read raw data from sensor and calc it to LUX value
  * @details	ALS and WHITE raw data need to be actual, after call fn wakeUp(),
- * 			should to do delay > 800 ms,
+ * 			should to do delay > 800 ms. Ranging take max 8 steps = 9 integrations.
  * @return structure AW_stru_t { (uint32_t)Lux ALS, (uint32_t)Lux WHITE } = ALS & WHATI values in lux 
  */
 AW_stru_t readAW();
 
+/**
+ * @brief read lux within deadline, resolution can be less
+ * @details	ranging by cl_VEMLrangeLatency: only gain & time, which valid count is ready
+ * 			in rest of lp_deadlineMs, are used. Result is the best estimate reachable in time.
+ * @param lp_deadlineMs - max ms of fn, lp_precise - if not nullptr, true is written
+ * 			if raw ALS count reach window 500 .. 10000 (target precision) or there is no better
+ * 			gain & time for this light, false if ranging was cut by deadline
+ * @return structure AW_stru_t { (uint32_t)Lux ALS, (uint32_t)Lux WHITE }
+ */
+AW_stru_t readAW(uint16_t lp_deadlineMs, bool *lp_precise = nullptr);
+
+/**
+ * @brief continuous measurement with hysteresis, call it again and again for monitoring
+ * @details	gain & time is kept, while raw ALS count is in band of hysteresis, it is
+ * 			window 500 .. 10000 wider by setHysteresis() steps of resolution. So steady light
+ * 			cost one integration per sample. Out of band => ranging as readAW().
+ * 			Fn wait (delay) for fresh conversion after previous call.
+ * @return structure AW_stru_t { (uint32_t)Lux ALS, (uint32_t)Lux WHITE }
+ */
+AW_stru_t readAWcont();
+
+/**
+ * @brief set band of hysteresis for readAWcont()
+ * @param lp_steps - steps of resolution (x2 each) to widen window 500 .. 10000 on both sides,
+ * 			0 - no hysteresis, 1 (default) - 250 .. 20000, 2 - 125 .. 40000, max 2, more is cut by saturation
+ */
+void setHysteresis(uint8_t lp_steps) { clv_hystShift = (lp_steps > 2) ? 2 : lp_steps; };
+
+/**
+ * @brief N samples with one ranging: readAW(), then integrations with the same gain & time
+ * @details	the last count of ranging is the 1st sample, so fn take ranging + (N - 1) integrations.
+ * 			If ranging take no step, its count can be old conversion, so it is skipped and
+ * 			the 1st sample is the next conversion.
+ * 			Statistics of ALS are calc by Welford, counts in fixed point Q8, integer math only.
+ * 			Correction of nonlinearity (setCorrection()) is applied to mean ALS lux only.
+ * @param lp_n - number of samples 1 .. 255
+ * @return structure AWstat_stru_t with mean lux, variance, min & max
+ */
+AWstat_stru_t readAWavg(uint8_t lp_n);
+
+/**
+ * @brief set gain & time of short and long exposure of readHDR()
+ * @param lp_short - index of gain & time for high light, lp_long - for low light,
+ * 			default {0, 0} = 1/8 25 ms and {2, 3} = x1 200 ms
+ */
+void setHDR(GTidx_stru_t lp_short, GTidx_stru_t lp_long) { clv_hdrShort = lp_short; clv_hdrLong = lp_long; };
+
+/**
+ * @brief HDR measurement: short and long exposure one after other, merged to one lux
+ * @details	there is no ranging, fn always take 2 fresh integrations (default 25 + 200 ms), so it do not
+ * 			chase fast changing light. Order of exposures alternate, the last one of previous
+ * 			call is the first one, only one change of gain & time per call. The first exposure
+ * 			wait for conversion, which is finished after previous call read it, so count is not stale.
+ * 			Counts are merged by noise (Poisson): lux = (c_s + c_l) / (1/r_s + 1/r_l), r - lux per count,
+ * 			saturated exposure (count >= 0xF000) is ignored.
+ * 			Correction of nonlinearity (setCorrection()) is applied to exposure, which is used alone.
+ * @param lp_used - if not nullptr, exposures which give ALS lux are written, see hdrExp_t
+ * @return structure AW_stru_t { (uint32_t)Lux ALS, (uint32_t)Lux WHITE }
+ */
+AW_stru_t readHDR(hdrExp_t *lp_used = nullptr);
+
+/**
+ * @brief start non-blocking measurement, the same ranging of gain & time as readAW()
+ * @details	fn return at once, then call poll() in main loop until it return MEAS_READY.
+ * 			Between poll() calls i2c bus and CPU are free for other work.
+ */
+void beginMeasure();
+
+/**
+ * @brief do next step of non-blocking measurement, if time of integration is over
+ * @details	fn never call delay(), deadlines are calculated by millis() and integration time.
+ * @return MEAS_PENDING - sensor is integrating, MEAS_READY - result() is valid,
+ * 			MEAS_IDLE - beginMeasure() was not called.
+ */
+measSt_t poll();
+
+/**
+ * @brief result of last non-blocking measurement
+ * @return structure AW_stru_t { (uint32_t)Lux ALS, (uint32_t)Lux WHITE }, valid if poll() == MEAS_READY
+ */
+AW_stru_t result() { return clv_measAW; };
+
+/**
+ * @brief state of non-blocking measurement without any work, unlike poll()
+ */
+measSt_t measState() { return clv_measState; };
+
+/**
+ * @brief millis() of next step of non-blocking measurement, poll() do nothing before it
+ */
+uint32_t measDeadline() { return clv_measDeadline; };
+
+/**
+ * @brief number of ranging steps (change of gain & time) of last readAW() or poll(), max 8
+ */
+uint8_t steps() { return clv_steps; };
+
+/**
+ * @brief raw counts and gain & time of last result of readAW(), readAWcont(), poll() or psmSample()
+ * @return GTrawAW_stru_t = { index of gain & time, raw ALS, raw WHITE }
+ */
+GTrawAW_stru_t lastRaw() { return clv_lastRaw; };
+
 };
 
 #endif
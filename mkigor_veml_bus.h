@@ -0,0 +1,166 @@
+/**
+ * @brief	Transport (i2c bus) interface for mkigor_veml library.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	cl_VEML7700 use only this interface to talk with sensor, so it can work on any bus:
+ * 			Wire, Wire1, native driver of ESP-IDF or host simulator.
+ * 			To add new bus, make child class of cl_VEMLbus and give it to cl_VEML7700 constructor.
+ * 			Class cl_VEMLwire is adapter to Arduino TwoWire, it is used by default.
+ * 			VEML7700 has only address 0x10, more sensors on one bus need i2c mux TCA9548A:
+ * 			cl_TCA9548A is the mux, cl_TCA9548Achan is bus of one channel of the mux,
+ * 			so sensor is a pair (mux, channel).
+ * @example
+ * 			cl_VEMLwire wire;
+ * 			cl_TCA9548A mux(wire, 0x70);
+ * 			cl_TCA9548Achan ch0(mux, 0), ch1(mux, 1);
+ * 			cl_VEML7700 veml0(ch0), veml1(ch1);
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#ifndef mkigor_veml_bus_h
+#define mkigor_veml_bus_h
+
+//============================================================================================
+
+class cl_VEMLbus {
+public:
+virtual ~cl_VEMLbus() {};
+
+/**
+ * @brief init bus, is not called by library, call it in setup() if bus need it
+ * @return true if OK
+ */
+virtual bool begin() { return true; };
+
+/**
+ * @brief write bytes to device and send stop bit
+ * @param lp_addr - i2c address of device, lp_data - bytes to write, lp_len - number of bytes
+ * @return true if device ACK all bytes
+ */
+virtual bool write(uint8_t lp_addr, const uint8_t *lp_data, uint8_t lp_len) = 0;
+
+/**
+ * @brief read bytes from device and send stop bit
+ * @param lp_addr - i2c address of device, lp_data - buffer for bytes, lp_len - number of bytes
+ * @return true if all bytes are received
+ */
+virtual bool read(uint8_t lp_addr, uint8_t *lp_data, uint8_t lp_len) = 0;
+
+/**
+ * @brief write bytes, then repeated start (no stop bit) and read bytes, stop bit at the end
+ * @param lp_addr - i2c address of device, lp_wdata, lp_wlen - bytes to write,
+ * 			lp_rdata, lp_rlen - buffer for read bytes
+ * @return true if OK
+ */
+virtual bool writeRead(uint8_t lp_addr, const uint8_t *lp_wdata, uint8_t lp_wlen,
+		uint8_t *lp_rdata, uint8_t lp_rlen) = 0;
+};
+
+//============================================================================================
+
+class cl_VEMLwire : public cl_VEMLbus {
+private:
+	TwoWire *clv_wire;			///	pointer, not reference, so adapter can be copied and assigned
+
+public:
+	cl_VEMLwire(TwoWire &lp_wire = Wire) : clv_wire(&lp_wire) {};
+
+	bool begin() override {
+		clv_wire->begin();
+		return true;
+	};
+
+	bool write(uint8_t lp_addr, const uint8_t *lp_data, uint8_t lp_len) override {
+		clv_wire->beginTransmission(lp_addr);
+		for (uint8_t i = 0; i < lp_len; i++)
+			if (clv_wire->write(lp_data[i]) != 1) return false;
+		return clv_wire->endTransmission() == 0;
+	};
+
+	bool read(uint8_t lp_addr, uint8_t *lp_data, uint8_t lp_len) override {
+		if (clv_wire->requestFrom(lp_addr, (unsigned long)lp_len, true) != lp_len) return false;	/// stop bit after request
+		for (uint8_t i = 0; i < lp_len; i++) lp_data[i] = clv_wire->read();
+		return true;
+	};
+
+	bool writeRead(uint8_t lp_addr, const uint8_t *lp_wdata, uint8_t lp_wlen,
+			uint8_t *lp_rdata, uint8_t lp_rlen) override {
+		clv_wire->beginTransmission(lp_addr);
+		for (uint8_t i = 0; i < lp_wlen; i++)
+			if (clv_wire->write(lp_wdata[i]) != 1) return false;
+		if (clv_wire->endTransmission(false)) return false;	///	don't send stop bit here
+		return read(lp_addr, lp_rdata, lp_rlen);
+	};
+};
+
+//============================================================================================
+
+class cl_TCA9548A {
+private:
+	cl_VEMLbus	&clv_bus;
+	uint8_t		clv_i2cAddr;
+	uint8_t		clv_channel = 0xFF;		///	cached selected channel, 0xFF - unknown
+
+public:
+	/// lp_bus - bus of mux, lp_addr - i2c address of mux 0x70 .. 0x77
+	cl_TCA9548A(cl_VEMLbus &lp_bus, uint8_t lp_addr = 0x70) : clv_bus(lp_bus), clv_i2cAddr(lp_addr) {};
+
+/**
+ * @brief select channel of mux, i2c transaction is only if channel is changed
+ * @param lp_channel - channel 0 - 7
+ * @return true if OK
+ */
+bool select(uint8_t lp_channel) {
+	if (lp_channel == clv_channel) return true;
+	uint8_t lv_reg = 1 << (lp_channel & 0x07);	///	control register, bit per channel
+	if (!clv_bus.write(clv_i2cAddr, &lv_reg, 1)) {
+		clv_channel = 0xFF;
+		return false;
+	}
+	clv_channel = lp_channel;
+	return true;
+};
+
+/// forget cached channel, next select() write it again, call it after bus error or mux reset
+void invalidate() { clv_channel = 0xFF; };
+
+/// bus of mux
+cl_VEMLbus &bus() { return clv_bus; };
+};
+
+//============================================================================================
+
+class cl_TCA9548Achan : public cl_VEMLbus {
+private:
+	cl_TCA9548A	&clv_mux;
+	uint8_t		clv_channel;
+
+public:
+	cl_TCA9548Achan(cl_TCA9548A &lp_mux, uint8_t lp_channel) : clv_mux(lp_mux), clv_channel(lp_channel) {};
+
+	bool write(uint8_t lp_addr, const uint8_t *lp_data, uint8_t lp_len) override {
+		if (!clv_mux.select(clv_channel)) return false;
+		if (clv_mux.bus().write(lp_addr, lp_data, lp_len)) return true;
+		clv_mux.invalidate();
+		return false;
+	};
+
+	bool read(uint8_t lp_addr, uint8_t *lp_data, uint8_t lp_len) override {
+		if (!clv_mux.select(clv_channel)) return false;
+		if (clv_mux.bus().read(lp_addr, lp_data, lp_len)) return true;
+		clv_mux.invalidate();
+		return false;
+	};
+
+	bool writeRead(uint8_t lp_addr, const uint8_t *lp_wdata, uint8_t lp_wlen,
+			uint8_t *lp_rdata, uint8_t lp_rlen) override {
+		if (!clv_mux.select(clv_channel)) return false;
+		if (clv_mux.bus().writeRead(lp_addr, lp_wdata, lp_wlen, lp_rdata, lp_rlen)) return true;
+		clv_mux.invalidate();
+		return false;
+	};
+};
+
+#endif
+//============================================================================================
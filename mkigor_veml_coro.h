@@ -0,0 +1,244 @@
+/**
+ * @brief	Coroutine (C++20) API for sensor light VEML7700.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	co_await vemlMeasure(veml) do the same ranging as readAW(), but suspend on deadlines
+ * 			of integration and before i2c transactions, so many sensors and network tasks work
+ * 			together without hand-written state machines.
+ * 			cl_VEMLsched is minimal single thread scheduler by millis(). On MCU call runOnce()
+ * 			in loop(), or run() which delay() until the next deadline. On host with extras/host
+ * 			millis() & delay() are virtual clock, so run() is host scheduler on virtual clock
+ * 			and the same code is benchmarked on Linux:
+ * 			g++ -std=c++20 -I. -Iextras/host mkigor_veml*.cpp extras/host/veml_sim.cpp main.cpp,
+ * 			see extras/bench/veml_coro_bench.cpp.
+ * 			Awaiters work only inside tasks, which are run by cl_VEMLsched.
+ * 			File is empty if compiler is older than C++20.
+ * @example
+ * 			cl_VEMLtask<void> job(cl_VEML7700 &veml) {
+ * 				AW_stru_t aw = co_await vemlMeasure(veml);
+ * 				co_await vemlSleepUntil(millis() + 1000);
+ * 				...
+ * 			}
+ * 			cl_VEMLsched sched;
+ * 			sched.spawn(job(veml1));	sched.spawn(job(veml2));
+ * 			sched.run();
+ */
+
+#ifndef mkigor_veml_coro_h
+#define mkigor_veml_coro_h
+
+#if (__cplusplus >= 202002L) && __has_include(<coroutine>)
+
+#include <coroutine>
+#include <exception>
+#include <mkigor_veml.h>
+
+//============================================================================================
+
+/// Promise part, which is the same for all types of result
+struct VEMLpromiseBase_stru_t {
+	std::coroutine_handle<> continuation;		///	who co_await this task, resume it at the end
+
+	std::suspend_always initial_suspend() noexcept { return {}; };	///	lazy, start by co_await or spawn()
+
+	struct finalAwaiter_stru_t {
+		bool await_ready() noexcept { return false; };
+		template <typename P>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<P> lp_h) noexcept {
+			if (lp_h.promise().continuation) return lp_h.promise().continuation;
+			return std::noop_coroutine();		///	root task, scheduler see done()
+		};
+		void await_resume() noexcept {};
+	};
+	finalAwaiter_stru_t final_suspend() noexcept { return {}; };
+	void unhandled_exception() { std::terminate(); };	///	result of task is not valid, never resume caller
+};
+
+/**
+ * @brief task (coroutine) with result T, co_await it to run and take result
+ */
+template <typename T>
+class cl_VEMLtask {
+public:
+	struct promise_type : VEMLpromiseBase_stru_t {
+		T value;
+		cl_VEMLtask get_return_object() {
+			return cl_VEMLtask(std::coroutine_handle<promise_type>::from_promise(*this));
+		};
+		void return_value(T lp_value) { value = lp_value; };
+	};
+
+	explicit cl_VEMLtask(std::coroutine_handle<promise_type> lp_h) : clv_h(lp_h) {};
+	cl_VEMLtask(cl_VEMLtask &&lp_other) noexcept : clv_h(lp_other.clv_h) { lp_other.clv_h = nullptr; };
+	cl_VEMLtask(const cl_VEMLtask &) = delete;
+	~cl_VEMLtask() { if (clv_h) clv_h.destroy(); };
+
+	bool await_ready() { return false; };
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> lp_caller) {
+		clv_h.promise().continuation = lp_caller;
+		return clv_h;			///	start task at once, symmetric transfer
+	};
+	T await_resume() { return clv_h.promise().value; };
+
+	/// give handle to scheduler, task object is empty after it
+	std::coroutine_handle<> release() { std::coroutine_handle<> lv_h = clv_h; clv_h = nullptr; return lv_h; };
+
+private:
+	std::coroutine_handle<promise_type> clv_h;
+};
+
+template <>
+class cl_VEMLtask<void> {
+public:
+	struct promise_type : VEMLpromiseBase_stru_t {
+		cl_VEMLtask get_return_object() {
+			return cl_VEMLtask(std::coroutine_handle<promise_type>::from_promise(*this));
+		};
+		void return_void() {};
+	};
+
+	explicit cl_VEMLtask(std::coroutine_handle<promise_type> lp_h) : clv_h(lp_h) {};
+	cl_VEMLtask(cl_VEMLtask &&lp_other) noexcept : clv_h(lp_other.clv_h) { lp_other.clv_h = nullptr; };
+	cl_VEMLtask(const cl_VEMLtask &) = delete;
+	~cl_VEMLtask() { if (clv_h) clv_h.destroy(); };
+
+	bool await_ready() { return false; };
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> lp_caller) {
+		clv_h.promise().continuation = lp_caller;
+		return clv_h;
+	};
+	void await_resume() {};
+
+	std::coroutine_handle<> release() { std::coroutine_handle<> lv_h = clv_h; clv_h = nullptr; return lv_h; };
+
+private:
+	std::coroutine_handle<promise_type> clv_h;
+};
+
+//============================================================================================
+
+/**
+ * @brief minimal single thread scheduler of cl_VEMLtask<void> by millis()
+ */
+class cl_VEMLsched {
+private:
+	struct slot_stru_t {
+		std::coroutine_handle<> root;		///	task given to spawn(), nullptr - slot is free
+		std::coroutine_handle<> resume;		///	where to go on, it can be nested task
+		uint32_t wakeAt;					///	millis(), when resume
+	};
+	const static uint8_t	clv_maxTasks = 8;
+	slot_stru_t		clv_slot[clv_maxTasks] = {};
+	slot_stru_t		*clv_current = nullptr;	///	slot of running task, for awaiters
+
+	static cl_VEMLsched *&clf_active() { static cl_VEMLsched *lv_sched = nullptr; return lv_sched; };
+
+	/// resume one task, free slot if root task is done
+	void clf_resume(slot_stru_t &lp_slot) {
+		clv_current = &lp_slot;
+		clf_active() = this;
+		lp_slot.resume.resume();
+		clv_current = nullptr;
+		if (lp_slot.root.done()) {
+			lp_slot.root.destroy();
+			lp_slot.root = nullptr;
+		}
+	};
+
+public:
+/**
+ * @brief add task, it start at next runOnce() or run()
+ * @return false if there are max (8) tasks already
+ */
+bool spawn(cl_VEMLtask<void> &&lp_task) {
+	for (uint8_t i = 0; i < clv_maxTasks; i++) {
+		if (clv_slot[i].root) continue;
+		clv_slot[i].root = lp_task.release();
+		clv_slot[i].resume = clv_slot[i].root;
+		clv_slot[i].wakeAt = millis();
+		return true;
+	}
+	return false;
+};
+
+/**
+ * @brief resume all tasks, which deadline is over, do not wait
+ * @return number of tasks, which are not done
+ */
+uint8_t runOnce() {
+	uint8_t lv_alive = 0;
+	for (uint8_t i = 0; i < clv_maxTasks; i++) {
+		if (!clv_slot[i].root) continue;
+		if ((int32_t)(millis() - clv_slot[i].wakeAt) >= 0) clf_resume(clv_slot[i]);
+		if (clv_slot[i].root) lv_alive++;
+	}
+	return lv_alive;
+};
+
+/**
+ * @brief the earliest deadline of tasks, millis() if there is no task
+ */
+uint32_t nextWake() {
+	uint32_t lv_next = millis();
+	bool lv_found = false;
+	for (uint8_t i = 0; i < clv_maxTasks; i++) {
+		if (!clv_slot[i].root) continue;
+		if (!lv_found || ((int32_t)(clv_slot[i].wakeAt - lv_next) < 0)) lv_next = clv_slot[i].wakeAt;
+		lv_found = true;
+	}
+	return lv_next;
+};
+
+/**
+ * @brief run until all tasks are done, delay() between deadlines (virtual clock on host)
+ */
+void run() {
+	while (runOnce()) {
+		int32_t lv_wait = (int32_t)(nextWake() - millis());
+		if (lv_wait > 0) delay(lv_wait);
+	}
+};
+
+/// awaiter: suspend running task until millis() >= wakeAt, yield - suspend anyway
+struct sleepUntil_stru_t {
+	uint32_t wakeAt;
+	bool yield;
+	bool await_ready() { return !yield && ((int32_t)(millis() - wakeAt) >= 0); };
+	void await_suspend(std::coroutine_handle<> lp_h) {
+		slot_stru_t *lv_slot = clf_active()->clv_current;
+		lv_slot->resume = lp_h;
+		lv_slot->wakeAt = wakeAt;
+	};
+	void await_resume() {};
+};
+};
+
+//============================================================================================
+
+/**
+ * @brief suspend task until millis() >= lp_ms, other tasks work meanwhile
+ */
+inline cl_VEMLsched::sleepUntil_stru_t vemlSleepUntil(uint32_t lp_ms) { return { lp_ms, false }; }
+
+/**
+ * @brief suspend task and let other tasks work, task go on at next runOnce()
+ */
+inline cl_VEMLsched::sleepUntil_stru_t vemlYield() { return { millis(), true }; }
+
+/**
+ * @brief measure light, the same ranging as readAW(), by non-blocking beginMeasure() & poll()
+ * @details	task suspend until deadline of integration and before each poll() with i2c transaction
+ * @return structure AW_stru_t { (uint32_t)Lux ALS, (uint32_t)Lux WHITE }
+ */
+inline cl_VEMLtask<AW_stru_t> vemlMeasure(cl_VEML7700 &lp_veml) {
+	lp_veml.beginMeasure();
+	for (;;) {
+		co_await vemlSleepUntil(lp_veml.measDeadline());
+		co_await vemlYield();					///	i2c transaction is next, let others go before
+		if (lp_veml.poll() == MEAS_READY) break;
+	}
+	co_return lp_veml.result();
+}
+
+#endif
+#endif
+//============================================================================================
@@ -0,0 +1,86 @@
+/**
+ * @brief	Group of sensors VEML7700, measure all of them at the same time.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	See mkigor_veml_group.h
+ */
+
+#include <mkigor_veml_group.h>
+
+//============================================================================================
+
+/**
+ * @brief add sensor to group, sensor must be init by check() before
+ * @return false if group is full (max 8 sensors)
+ */
+bool cl_VEMLgroup::add(cl_VEML7700 &lp_sensor) {
+	if (clv_nSensors >= clv_maxSensors) return false;
+	clv_sensor[clv_nSensors++] = &lp_sensor;
+	return true;
+}
+
+/**
+ * @brief start non-blocking measurement of all sensors, no i2c transaction
+ */
+void cl_VEMLgroup::beginMeasure() {
+	for (uint8_t i = 0; i < clv_nSensors; i++) clv_sensor[i]->beginMeasure();
+}
+
+/**
+ * @brief serve sensors, which deadline is over, by order of deadline
+ * @return MEAS_READY - all sensors are ready, MEAS_PENDING - somebody is integrating,
+ * 			MEAS_IDLE - group is empty or beginMeasure() was not called
+ */
+measSt_t cl_VEMLgroup::poll() {
+	if (clv_nSensors == 0) return MEAS_IDLE;
+	uint8_t lv_served = 0;			///	bit mask of sensors, served in this call
+	for (uint8_t k = 0; k < clv_nSensors; k++) {
+		///	find pending sensor with the earliest deadline, which was not served yet
+		int8_t lv_idx = -1;
+		for (uint8_t i = 0; i < clv_nSensors; i++) {
+			if ((lv_served & (1 << i)) || (clv_sensor[i]->measState() != MEAS_PENDING)) continue;
+			if ((lv_idx < 0) || ((int32_t)(clv_sensor[i]->measDeadline() - clv_sensor[lv_idx]->measDeadline()) < 0))
+				lv_idx = i;
+		}
+		if ((lv_idx < 0) || ((int32_t)(millis() - clv_sensor[lv_idx]->measDeadline()) < 0)) break;
+		lv_served |= 1 << lv_idx;
+		clv_sensor[lv_idx]->poll();
+	}
+
+	measSt_t lv_state = MEAS_READY;
+	for (uint8_t i = 0; i < clv_nSensors; i++) {
+		measSt_t lv_st = clv_sensor[i]->measState();
+		if (lv_st == MEAS_IDLE) return MEAS_IDLE;
+		if (lv_st == MEAS_PENDING) lv_state = MEAS_PENDING;
+	}
+	return lv_state;
+}
+
+/**
+ * @brief the earliest millis(), when poll() has work, CPU can sleep until it
+ */
+uint32_t cl_VEMLgroup::nextDeadline() {
+	uint32_t lv_next = millis();
+	bool lv_found = false;
+	for (uint8_t i = 0; i < clv_nSensors; i++) {
+		if (clv_sensor[i]->measState() != MEAS_PENDING) continue;
+		uint32_t lv_dl = clv_sensor[i]->measDeadline();
+		if (!lv_found || ((int32_t)(lv_dl - lv_next) < 0)) lv_next = lv_dl;
+		lv_found = true;
+	}
+	return lv_next;
+}
+
+/**
+ * @brief blocking measurement of all sensors, delay() is only between deadlines
+ * @param lp_AW - array of size() results in order of add()
+ */
+void cl_VEMLgroup::readAll(AW_stru_t *lp_AW) {
+	beginMeasure();
+	while (poll() == MEAS_PENDING) {
+		int32_t lv_wait = (int32_t)(nextDeadline() - millis());
+		if (lv_wait > 0) delay(lv_wait);
+	}
+	for (uint8_t i = 0; i < clv_nSensors; i++) lp_AW[i] = result(i);
+}
+
+//============================================================================================
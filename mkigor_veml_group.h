@@ -0,0 +1,70 @@
+/**
+ * @brief	Group of sensors VEML7700, measure all of them at the same time.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	readAW() of N sensors one by one take N times more time. cl_VEMLgroup start
+ * 			non-blocking measurement of all sensors together, so they integrate in parallel,
+ * 			and serve them by order of deadline, one i2c transaction after other, they never collide.
+ * 			Result is ready, when the slowest sensor is ready, latency is almost the same
+ * 			as for one sensor. Sensors can be on different buses or behind i2c mux.
+ * @example
+ * 			cl_VEML7700 veml1(Wire), veml2(Wire1);
+ * 			cl_VEMLgroup group;
+ * 			group.add(veml1);	group.add(veml2);
+ * 			group.beginMeasure();
+ * 			...	in loop: if (group.poll() == MEAS_READY) lux1 = group.result(0).als1;
+ */
+
+#include <mkigor_veml.h>
+
+#ifndef mkigor_veml_group_h
+#define mkigor_veml_group_h
+
+//============================================================================================
+
+class cl_VEMLgroup {
+private:
+	const static uint8_t	clv_maxSensors = 8;
+	cl_VEML7700		*clv_sensor[clv_maxSensors];
+	uint8_t			clv_nSensors = 0;
+
+public:
+/**
+ * @brief add sensor to group, sensor must be init by check() before
+ * @return false if group is full (max 8 sensors)
+ */
+bool add(cl_VEML7700 &lp_sensor);
+
+/// number of sensors in group
+uint8_t size() { return clv_nSensors; };
+
+/**
+ * @brief start non-blocking measurement of all sensors, no i2c transaction
+ */
+void beginMeasure();
+
+/**
+ * @brief serve sensors, which deadline is over, by order of deadline
+ * @return MEAS_READY - all sensors are ready, MEAS_PENDING - somebody is integrating,
+ * 			MEAS_IDLE - group is empty or beginMeasure() was not called
+ */
+measSt_t poll();
+
+/**
+ * @brief the earliest millis(), when poll() has work, CPU can sleep until it
+ */
+uint32_t nextDeadline();
+
+/**
+ * @brief result of sensor number lp_idx (order of add()), valid if poll() == MEAS_READY
+ */
+AW_stru_t result(uint8_t lp_idx) { return clv_sensor[lp_idx]->result(); };
+
+/**
+ * @brief blocking measurement of all sensors, delay() is only between deadlines
+ * @param lp_AW - array of size() results in order of add()
+ */
+void readAll(AW_stru_t *lp_AW);
+};
+
+#endif
+//============================================================================================
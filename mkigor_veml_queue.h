@@ -0,0 +1,190 @@
+/**
+ * @brief	Lock-free queue of samples for background acquisition of VEML7700.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	One task (FreeRTOS task or std::thread on host) own the sensor and push samples,
+ * 			other task (network, log) pop them. Queue is single producer / single consumer ring,
+ * 			indexes are published by GCC __atomic builtins (acquire / release), so nobody
+ * 			take a lock and producer never wait for consumer. If queue is full, new sample
+ * 			is dropped and counted in overruns(), timing of acquisition is kept.
+ * 			Capacity N must be power of 2, one slot is not wasted, queue hold N samples.
+ * 			cl_VEMLlatest is slot of the latest sample for many readers (display, MQTT, ...),
+ * 			it is seqlock: writer never wait, reader copy 5 words and check sequence twice,
+ * 			it never take lock or touch i2c bus.
+ * 			cl_VEMLacq is acquisition loop: step() measure by readAWcont(), push sample to queue
+ * 			and publish it to latest slot.
+ * @example
+ * 			cl_VEMLqueue<16> queue;
+ * 			cl_VEMLlatest latest;
+ * 			cl_VEMLacq<16> acq(veml, queue, &latest);
+ * 			task 1:	for (;;) acq.step();
+ * 			task 2:	VEMLsample_stru_t s;	while (queue.pop(s)) send(s.aw.als1);
+ * 			task 3:	if (latest.read(s)) show(s.aw.als1);
+ */
+
+#include <string.h>
+#include <mkigor_veml.h>
+
+#ifndef mkigor_veml_queue_h
+#define mkigor_veml_queue_h
+
+//============================================================================================
+
+struct VEMLsample_stru_t	{
+	uint32_t		ms;		///	millis() when sample is taken
+	GTrawAW_stru_t	raw;	///	index of gain & time, raw ALS & WHITE counts
+	AW_stru_t		aw;		///	lux of ALS & WHITE
+};
+
+/**
+ * @brief single producer / single consumer lock-free ring of N samples
+ */
+template <uint16_t N = 16>
+class cl_VEMLqueue {
+	static_assert((N >= 2) && (N <= 0x8000) && ((N & (N - 1)) == 0), "capacity must be power of 2");
+
+private:
+	VEMLsample_stru_t	clv_buf[N];
+	uint16_t		clv_head = 0;		///	free running index of next pop, written by consumer
+	uint16_t		clv_tail = 0;		///	free running index of next push, written by producer
+	uint32_t		clv_overruns = 0;	///	dropped samples, written by producer
+
+public:
+/**
+ * @brief put sample to queue, call it only from producer task
+ * @return false if queue is full, sample is dropped and counted
+ */
+bool push(const VEMLsample_stru_t &lp_sample) {
+	uint16_t lv_tail = __atomic_load_n(&clv_tail, __ATOMIC_RELAXED);
+	uint16_t lv_head = __atomic_load_n(&clv_head, __ATOMIC_ACQUIRE);	///	slot is free after consumer read it
+	if ((uint16_t)(lv_tail - lv_head) >= N) {
+		__atomic_store_n(&clv_overruns, clv_overruns + 1, __ATOMIC_RELAXED);
+		return false;
+	}
+	clv_buf[lv_tail & (N - 1)] = lp_sample;
+	__atomic_store_n(&clv_tail, (uint16_t)(lv_tail + 1), __ATOMIC_RELEASE);	///	publish sample
+	return true;
+};
+
+/**
+ * @brief take the oldest sample from queue, call it only from consumer task
+ * @return false if queue is empty
+ */
+bool pop(VEMLsample_stru_t &lp_sample) {
+	uint16_t lv_head = __atomic_load_n(&clv_head, __ATOMIC_RELAXED);
+	uint16_t lv_tail = __atomic_load_n(&clv_tail, __ATOMIC_ACQUIRE);	///	sample is written before tail
+	if (lv_head == lv_tail) return false;
+	lp_sample = clv_buf[lv_head & (N - 1)];
+	__atomic_store_n(&clv_head, (uint16_t)(lv_head + 1), __ATOMIC_RELEASE);	///	give slot back
+	return true;
+};
+
+/// number of samples in queue, it is exact only in consumer task
+uint16_t size() {
+	return (uint16_t)(__atomic_load_n(&clv_tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&clv_head, __ATOMIC_RELAXED));
+};
+
+/// true if queue is full, producer can wait for free slot instead of drop sample
+bool full() {
+	return (uint16_t)(__atomic_load_n(&clv_tail, __ATOMIC_RELAXED) - __atomic_load_n(&clv_head, __ATOMIC_ACQUIRE)) >= N;
+};
+
+/// capacity of queue
+static constexpr uint16_t capacity() { return N; };
+
+/// number of samples dropped because queue was full, any task can read it
+uint32_t overruns() { return __atomic_load_n(&clv_overruns, __ATOMIC_RELAXED); };
+};
+
+//============================================================================================
+
+/**
+ * @brief the latest sample, one writer and any number of readers, seqlock
+ * @details	sequence is odd while writer copy sample. Reader retry if sequence was odd or
+ * 			changed during copy. Sample is kept as words with relaxed atomic access,
+ * 			so concurrent copy is not data race. Writer must not be preempted by reader,
+ * 			which spin in read() on the same core with higher priority, use tryRead() there.
+ */
+class cl_VEMLlatest {
+private:
+	static const uint8_t	clv_nWords = (sizeof(VEMLsample_stru_t) + 3) / 4;
+	uint32_t		clv_seq = 0;				///	0 - no sample yet, odd - writer is busy
+	uint32_t		clv_word[clv_nWords] = {};
+
+public:
+/**
+ * @brief publish sample, call it only from one writer task
+ */
+void publish(const VEMLsample_stru_t &lp_sample) {
+	uint32_t lv_word[clv_nWords] = {};
+	memcpy(lv_word, &lp_sample, sizeof(lp_sample));
+	uint32_t lv_seq = __atomic_load_n(&clv_seq, __ATOMIC_RELAXED);
+	__atomic_store_n(&clv_seq, lv_seq + 1, __ATOMIC_RELAXED);		///	odd: writing
+	__atomic_thread_fence(__ATOMIC_RELEASE);						///	odd sequence before data
+	for (uint8_t i = 0; i < clv_nWords; i++) __atomic_store_n(&clv_word[i], lv_word[i], __ATOMIC_RELAXED);
+	__atomic_store_n(&clv_seq, lv_seq + 2, __ATOMIC_RELEASE);		///	even: data before sequence
+};
+
+/**
+ * @brief one attempt to copy the latest sample, never wait
+ * @return false if there is no sample yet or writer is busy, lp_sample is not valid then
+ */
+bool tryRead(VEMLsample_stru_t &lp_sample) {
+	uint32_t lv_word[clv_nWords];
+	uint32_t lv_seq = __atomic_load_n(&clv_seq, __ATOMIC_ACQUIRE);
+	if ((lv_seq == 0) || (lv_seq & 1)) return false;
+	for (uint8_t i = 0; i < clv_nWords; i++) lv_word[i] = __atomic_load_n(&clv_word[i], __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);						///	data before second sequence
+	if (__atomic_load_n(&clv_seq, __ATOMIC_RELAXED) != lv_seq) return false;
+	memcpy(&lp_sample, lv_word, sizeof(lp_sample));
+	return true;
+};
+
+/**
+ * @brief copy the latest sample, retry while writer is busy
+ * @return false if there is no sample yet
+ */
+bool read(VEMLsample_stru_t &lp_sample) {
+	while (!tryRead(lp_sample))
+		if (__atomic_load_n(&clv_seq, __ATOMIC_RELAXED) == 0) return false;
+	return true;
+};
+
+/// number of published samples, reader can see that sample is new
+uint32_t count() { return __atomic_load_n(&clv_seq, __ATOMIC_ACQUIRE) / 2; };
+};
+
+//============================================================================================
+
+/**
+ * @brief acquisition loop: owner of sensor, measure and push samples to queue
+ */
+template <uint16_t N = 16>
+class cl_VEMLacq {
+private:
+	cl_VEML7700			&clv_veml;
+	cl_VEMLqueue<N>		&clv_queue;
+	cl_VEMLlatest		*clv_latest;
+
+public:
+	/// sensor must be init by check() before, only this object should use it after,
+	/// lp_latest - slot of the latest sample, nullptr - there is no slot
+	cl_VEMLacq(cl_VEML7700 &lp_veml, cl_VEMLqueue<N> &lp_queue, cl_VEMLlatest *lp_latest = nullptr)
+		: clv_veml(lp_veml), clv_queue(lp_queue), clv_latest(lp_latest) {};
+
+/**
+ * @brief measure one sample by readAWcont(), publish and push it, fn wait (delay) for fresh conversion
+ * @details	on FreeRTOS delay() is vTaskDelay(), so other tasks work while sensor is integrating
+ * @return false if queue was full and sample is dropped
+ */
+bool step() {
+	VEMLsample_stru_t lv_sample;
+	lv_sample.aw = clv_veml.readAWcont();
+	lv_sample.raw = clv_veml.lastRaw();
+	lv_sample.ms = millis();
+	if (clv_latest) clv_latest->publish(lv_sample);		///	latest slot is fresh even if queue is full
+	return clv_queue.push(lv_sample);
+};
+};
+
+#endif
+//============================================================================================
@@ -0,0 +1,147 @@
+/**
+ * @brief	Policies of ranging gain & time for sensor light VEML7700.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	See mkigor_veml_range.h
+ */
+
+#include <mkigor_veml_range.h>
+
+constexpr GTidx_stru_t cl_VEMLrangePredict::clv_ladder[cl_VEMLrangePredict::clv_nLadder];
+
+//============================================================================================
+
+/**
+ * @brief the most sensitive gain & time, where count is not more than lp_maxCount
+ * @details	ties (the same resolution) are solved by shorter time
+ * @param lp_scaled - count << resolShift() of its gain & time, lp_maxIdxTime - max index of time,
+ * 			lp_maxCount - max expected count
+ * @return index of gain & time, the least sensitive with lp_maxIdxTime if nothing fit
+ */
+GTidx_stru_t cl_VEMLrangeStep::clf_pick(uint32_t lp_scaled, uint8_t lp_maxIdxTime, uint32_t lp_maxCount) {
+	GTidx_stru_t lv_gt = { 0, 0 };
+	uint8_t lv_shift = 0xFF;
+	for (uint8_t t = 0; t <= lp_maxIdxTime; t++) {
+		for (uint8_t g = 0; g < cl_VEML7700::nGain(); g++) {
+			uint8_t lv_sh = cl_VEML7700::resolShift(g, t);
+			if (((lp_scaled >> lv_sh) <= lp_maxCount) && (lv_sh < lv_shift)) {
+				lv_shift = lv_sh;
+				lv_gt = { g, t };
+			}
+		}
+	}
+	return lv_gt;
+}
+
+/**
+ * @brief count scaled to resolution shift 0: count << resolShift(), saturated count (65535)
+ * 			is real count more than 65535, it is aimed 16 times less sensitive
+ * @param lp_ALSdata - raw ALS count, lp_shift - resolShift() of its gain & time
+ * @return scaled count for clf_pick()
+ */
+uint32_t cl_VEMLrangeStep::clf_scaled(uint16_t lp_ALSdata, uint8_t lp_shift) {
+	return (lp_ALSdata == 0xFFFF) ? (uint32_t)0xFFFF << (lp_shift + 4) : (uint32_t)lp_ALSdata << lp_shift;
+}
+
+/**
+ * @brief one step of ranging, increase or decrease gain or time index
+ * 	to keep raw data ALS in boindes 500 .. 10000
+ * @param lp_ALSdata - raw ALS count, lp_gt - current gain & time index, it is changed by fn
+ * @return false - raw ALS data is OK or sensivity is max / min already, no need to change gain & time
+ */
+bool cl_VEMLrangeStep::next(uint16_t lp_ALSdata, GTidx_stru_t &lp_gt) {
+	if ((lp_ALSdata >= clv_low) && (lp_ALSdata <= clv_high)) return false;
+	GTidx_stru_t lv_gt = lp_gt;
+	if (lp_ALSdata < clv_low) {
+		if (lp_gt.idxTime1 < 2) lp_gt.idxTime1 = 2;
+		else if (lp_gt.idxGain1 < (cl_VEML7700::nGain() - 1)) lp_gt.idxGain1++;
+		else if (lp_gt.idxTime1 < (cl_VEML7700::nTime() - 1)) lp_gt.idxTime1++;
+	}
+	else {
+		if (lp_gt.idxTime1 > 2)	lp_gt.idxTime1--;
+		else if (lp_gt.idxGain1 != 0)	lp_gt.idxGain1--;
+		else if (lp_gt.idxTime1 != 0) lp_gt.idxTime1--;
+	}
+	return (lv_gt.idxGain1 != lp_gt.idxGain1) || (lv_gt.idxTime1 != lp_gt.idxTime1);
+}
+
+/**
+ * @brief calc lux by raw ALS count and select the most sensitive gain & time of ladder,
+ * 	where expected count is not more than clv_predictMax. Count 0 or 65535 => one step.
+ * @param lp_ALSdata - raw ALS count, lp_gt - current gain & time index, it is changed by fn
+ * @return false - raw ALS data is OK or no better gain & time
+ */
+bool cl_VEMLrangePredict::next(uint16_t lp_ALSdata, GTidx_stru_t &lp_gt) {
+	if ((lp_ALSdata >= clv_low) && (lp_ALSdata <= clv_high)) return false;
+	if ((lp_ALSdata == 0) || (lp_ALSdata == 0xFFFF)) return cl_VEMLrangeStep::next(lp_ALSdata, lp_gt);
+
+	///	resolutions are power of 2 of each other, expected count = count << shift now >> shift new
+	uint32_t lv_scaled = (uint32_t)lp_ALSdata << cl_VEML7700::resolShift(lp_gt.idxGain1, lp_gt.idxTime1);
+	GTidx_stru_t lv_gt = clv_ladder[0];
+	for (uint8_t i = 1; i < clv_nLadder; i++) {
+		if ((lv_scaled >> cl_VEML7700::resolShift(clv_ladder[i].idxGain1, clv_ladder[i].idxTime1)) > clv_predictMax) break;
+		lv_gt = clv_ladder[i];
+	}
+#ifdef DEBUG_EN
+	printf("Predict -> ALS=%d, gainIdx=%d, timeIdx=%d\n", lp_ALSdata, lv_gt.idxGain1, lv_gt.idxTime1);
+#endif
+	bool lv_changed = (lv_gt.idxGain1 != lp_gt.idxGain1) || (lv_gt.idxTime1 != lp_gt.idxTime1);
+	lp_gt = lv_gt;
+	return lv_changed;
+}
+
+//============================================================================================
+
+void cl_VEMLrangeLatency::begin() {
+	clv_t0 = millis();
+	clv_met = false;
+}
+
+/**
+ * @brief jump as predict, but only to time, which valid count is ready in rest of budget
+ * @param lp_ALSdata - raw ALS count, lp_gt - current gain & time index, it is changed by fn
+ * @return false - raw ALS data is OK, no better gain & time or budget is over
+ */
+bool cl_VEMLrangeLatency::next(uint16_t lp_ALSdata, GTidx_stru_t &lp_gt) {
+	if ((lp_ALSdata >= clv_low) && (lp_ALSdata <= clv_high)) {
+		clv_met = true;
+		return false;
+	}
+	uint8_t lv_shift = cl_VEML7700::resolShift(lp_gt.idxGain1, lp_gt.idxTime1);
+	///	no better gain & time at all, not cut by budget: count is the best sensor can give
+	uint8_t lv_edge = (lp_ALSdata < clv_low)
+		? cl_VEML7700::resolShift(cl_VEML7700::nGain() - 1, cl_VEML7700::nTime() - 1) : cl_VEML7700::resolShift(0, 0);
+	if (lv_shift == lv_edge) {
+		clv_met = true;
+		return false;
+	}
+	int32_t lv_rest = (int32_t)clv_budgetMs - (int32_t)(millis() - clv_t0);
+	if (lv_rest < (int32_t)cl_VEML7700::readyMs(0)) return false;		///	even 25 ms is too long
+	uint8_t lv_maxIdxTime = 0;
+	while ((lv_maxIdxTime + 1 < cl_VEML7700::nTime())
+			&& ((int32_t)cl_VEML7700::readyMs(lv_maxIdxTime + 1) <= lv_rest)) lv_maxIdxTime++;
+
+	GTidx_stru_t lv_gt = clf_pick(clf_scaled(lp_ALSdata, lv_shift), lv_maxIdxTime, clv_high * 4 / 5);
+	///	low count and no more sensitive gain & time in budget: current count is the best estimate
+	if ((lp_ALSdata < clv_low) && (cl_VEML7700::resolShift(lv_gt.idxGain1, lv_gt.idxTime1) >= lv_shift)) return false;
+	bool lv_changed = (lv_gt.idxGain1 != lp_gt.idxGain1) || (lv_gt.idxTime1 != lp_gt.idxTime1);
+	lp_gt = lv_gt;
+	return lv_changed;
+}
+
+//============================================================================================
+
+/**
+ * @brief jump to the most sensitive gain & time, where count is not more than clv_maxCount
+ * @param lp_ALSdata - raw ALS count, lp_gt - current gain & time index, it is changed by fn
+ * @return false - no more sensitive gain & time without saturation
+ */
+bool cl_VEMLrangeMaxRes::next(uint16_t lp_ALSdata, GTidx_stru_t &lp_gt) {
+	uint8_t lv_shift = cl_VEML7700::resolShift(lp_gt.idxGain1, lp_gt.idxTime1);
+	if ((lp_ALSdata != 0xFFFF) && (lp_ALSdata > clv_maxCount / 2)) return false;	///	next one saturate
+	GTidx_stru_t lv_gt = clf_pick(clf_scaled(lp_ALSdata, lv_shift), cl_VEML7700::nTime() - 1, clv_maxCount);
+	bool lv_changed = (lv_gt.idxGain1 != lp_gt.idxGain1) || (lv_gt.idxTime1 != lp_gt.idxTime1);
+	lp_gt = lv_gt;
+	return lv_changed;
+}
+
+//============================================================================================
@@ -0,0 +1,98 @@
+/**
+ * @brief	Policies of ranging gain & time for sensor light VEML7700.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	Policy decide, which gain & time is next, by raw ALS count. Set it by
+ * 			cl_VEML7700.setRangePolicy(), so each use case has own tradeoff of latency & precision.
+ * 			cl_VEMLrangeStep	- std (default), window 500 .. 10000, one index per integration,
+ * 								  order: time to 100 ms, then gain, then time.
+ * 			cl_VEMLrangePredict	- calc lux by one reading and jump to ladder of step policy.
+ * 			cl_VEMLrangeLatency	- only gain & time, which integration fits in budget of ms.
+ * 			cl_VEMLrangeMaxRes	- max resolution, the most sensitive gain & time without saturation.
+ * @example
+ * 			cl_VEMLrangeLatency range250(250);
+ * 			veml.setRangePolicy(range250);
+ * 			AW_stru_t aw = veml.readAW();
+ */
+
+#include <mkigor_veml.h>
+
+#ifndef mkigor_veml_range_h
+#define mkigor_veml_range_h
+
+//============================================================================================
+
+class cl_VEMLrangeStep : public cl_VEMLrange {
+protected:
+	const static uint16_t	clv_low = cd_ALS_LOW;		///	window of raw ALS count
+	const static uint16_t	clv_high = cd_ALS_HIGH;
+
+/**
+ * @brief the most sensitive gain & time, where count is not more than lp_maxCount
+ * @details	ties (the same resolution) are solved by shorter time
+ * @param lp_scaled - count << resolShift() of its gain & time, lp_maxIdxTime - max index of time,
+ * 			lp_maxCount - max expected count
+ * @return index of gain & time, the least sensitive with lp_maxIdxTime if nothing fit
+ */
+static GTidx_stru_t clf_pick(uint32_t lp_scaled, uint8_t lp_maxIdxTime, uint32_t lp_maxCount);
+
+/**
+ * @brief count scaled to resolution shift 0: count << resolShift(), saturated count (65535)
+ * 			is real count more than 65535, it is aimed 16 times less sensitive
+ * @param lp_ALSdata - raw ALS count, lp_shift - resolShift() of its gain & time
+ * @return scaled count for clf_pick()
+ */
+static uint32_t clf_scaled(uint16_t lp_ALSdata, uint8_t lp_shift);
+
+public:
+bool next(uint16_t lp_ALSdata, GTidx_stru_t &lp_gt) override;
+};
+
+//============================================================================================
+
+class cl_VEMLrangePredict : public cl_VEMLrangeStep {
+protected:
+	/// Ladder of gain & time index from min to max sensivity, the same way as step ranging go
+	const static uint8_t	clv_nLadder = 9;
+	static constexpr GTidx_stru_t	clv_ladder[clv_nLadder] = {
+			{0, 0}, {0, 1}, {0, 2}, {1, 2}, {2, 2}, {3, 2}, {3, 3}, {3, 4}, {3, 5} };
+	const static uint16_t	clv_predictMax = 8000;	///	max expected count for predict, margin to 10000
+
+public:
+bool next(uint16_t lp_ALSdata, GTidx_stru_t &lp_gt) override;
+};
+
+//============================================================================================
+
+class cl_VEMLrangeLatency : public cl_VEMLrangeStep {
+private:
+	uint16_t	clv_budgetMs;
+	uint32_t	clv_t0 = 0;			///	millis() of begin()
+	bool		clv_met = false;
+
+public:
+	/// lp_budgetMs - max ms for all ranging, from begin() to the last valid count
+	cl_VEMLrangeLatency(uint16_t lp_budgetMs = 250) : clv_budgetMs(lp_budgetMs) {};
+
+/// set new budget, ms
+void setBudget(uint16_t lp_budgetMs) { clv_budgetMs = lp_budgetMs; };
+
+/// true if last ranging stop in window 500 .. 10000 or sensor has no better gain & time
+/// (light is out of window at the least / the most sensitive one), false if it was stopped by budget
+bool met() { return clv_met; };
+
+void begin() override;
+bool next(uint16_t lp_ALSdata, GTidx_stru_t &lp_gt) override;
+};
+
+//============================================================================================
+
+class cl_VEMLrangeMaxRes : public cl_VEMLrangeStep {
+protected:
+	const static uint16_t	clv_maxCount = 50000;	///	margin to saturation 65535
+
+public:
+bool next(uint16_t lp_ALSdata, GTidx_stru_t &lp_gt) override;
+};
+
+#endif
+//============================================================================================
@@ -0,0 +1,126 @@
+/**
+ * @brief	Report by exception for sensor light VEML7700: emit sample only if lux is changed.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	See mkigor_veml_rbe.h
+ */
+
+#include <mkigor_veml_rbe.h>
+
+//============================================================================================
+
+/**
+ * @brief delta of lux, which emit sample, the smallest of absolute & relative
+ * @param lp_lux - the last emitted lux
+ * @return delta, lux, 0 - only heartbeat emit sample
+ */
+uint32_t cl_VEMLrbe::clf_delta(uint32_t lp_lux) {
+	uint32_t lv_rel = (uint32_t)(((uint64_t)lp_lux * clv_relPct + 99) / 100);
+	if (lv_rel == 0) lv_rel = 1;		///	dark: any lux is change
+	if (clv_relPct == 0) return clv_absLux;
+	if (clv_absLux == 0) return lv_rel;
+	return (clv_absLux < lv_rel) ? clv_absLux : lv_rel;
+}
+
+/**
+ * @brief the smallest raw count, which lux is >= lp_lux, binary search
+ * @param lp_lux - lux, lp_gt - index of gain & time of count, lp_corr - lux is corrected
+ * @return count, 0x10000 if there is no such count
+ */
+uint32_t cl_VEMLrbe::clf_count(uint32_t lp_lux, GTidx_stru_t lp_gt, bool lp_corr) {
+	uint32_t lv_lo = 0, lv_hi = 0x10000;
+	while (lv_lo < lv_hi) {
+		uint32_t lv_mid = (lv_lo + lv_hi) / 2;
+		uint32_t lv_lux = lp_corr ? cl_VEML7700::countsToLuxCorr((uint16_t)lv_mid, lp_gt)
+			: cl_VEML7700::countsToLux((uint16_t)lv_mid, lp_gt);
+		if (lv_lux >= lp_lux) lv_hi = lv_mid;
+		else lv_lo = lv_mid + 1;
+	}
+	return lv_lo;
+}
+
+/**
+ * @brief write band of the last emitted lux to thresholds of sensor and clear flags
+ */
+void cl_VEMLrbe::clf_arm() {
+	uint32_t lv_delta = clf_delta(clv_lastAW.als1);
+	if ((lv_delta == 0) || (clv_veml.filterMode() != FILT_NONE)) {
+		if (clv_armed) clv_veml.disableInt();
+		clv_armed = false;
+		return;
+	}
+	///	band of lux last - delta + 1 .. last + delta - 1 (delta itself must emit) is counts
+	///	lv_cLow .. lv_cHigh - 1 by the same rounded lux as software check, flag is set out of it
+	GTidx_stru_t lv_gt = clv_veml.readGainTime();
+	bool lv_corr = clv_veml.correction() && cl_VEML7700::needCorr(lv_gt);
+	uint32_t lv_cLow = (clv_lastAW.als1 > lv_delta) ? clf_count(clv_lastAW.als1 - lv_delta + 1, lv_gt, lv_corr) : 0;
+	if (lv_cLow > 0xFFFF) lv_cLow = 0xFFFF;
+	uint32_t lv_cHigh = clf_count(clv_lastAW.als1 + lv_delta, lv_gt, lv_corr);
+	clv_veml.setThresholdCounts((uint16_t)lv_cLow, (uint16_t)(lv_cHigh - 1));
+	clv_veml.readInt();					///	clear flags of previous band
+	clv_armed = true;
+}
+
+/**
+ * @brief switch on (default) / off check by thresholds of sensor
+ */
+void cl_VEMLrbe::useThresholds(bool lp_on) {
+	clv_useInt = lp_on;
+	if (!lp_on && clv_armed) clv_veml.disableInt();
+	clv_armed = false;
+}
+
+/**
+ * @brief software check of sample, sample is the last emitted one if it is emitted
+ * @param lp_AW - sample, lp_ms - millis() of sample
+ * @return true if sample should be emitted
+ */
+bool cl_VEMLrbe::changed(const AW_stru_t &lp_AW, uint32_t lp_ms) {
+	bool lv_emit = !clv_sent;
+	if (clv_sent && clv_heartbeatMs && ((uint32_t)(lp_ms - clv_lastMs) >= clv_heartbeatMs)) lv_emit = true;
+	uint32_t lv_delta = clf_delta(clv_lastAW.als1);
+	if (clv_sent && lv_delta) {
+		uint32_t lv_diff = (lp_AW.als1 > clv_lastAW.als1) ? lp_AW.als1 - clv_lastAW.als1 : clv_lastAW.als1 - lp_AW.als1;
+		if (lv_diff >= lv_delta) lv_emit = true;
+	}
+	if (lv_emit) {
+		clv_lastAW = lp_AW;
+		clv_lastMs = lp_ms;
+		clv_sent = true;
+	}
+	return lv_emit;
+}
+
+/**
+ * @brief one cycle of report by exception, call it in loop
+ * @details	if band is in thresholds and heartbeat is not due, fn read ALS_INT once per conversion
+ * 			and return at once. Else it measure by readAWcont() (delay for fresh conversion)
+ * 			and check sample. Thresholds are armed again, if gain & time was not changed.
+ * @param lp_AW - emitted sample is written here
+ * @return true if sample is emitted
+ */
+bool cl_VEMLrbe::sample(AW_stru_t &lp_AW) {
+	bool lv_beat = clv_heartbeatMs && ((uint32_t)(millis() - clv_lastMs) >= clv_heartbeatMs);
+	if (clv_armed && !lv_beat) {
+		if ((int32_t)(millis() - clv_next) < 0) return false;		///	no fresh conversion, no i2c
+		clv_next = millis() + cl_VEML7700::readyMs(clv_veml.readGainTime().idxTime1);
+		if (!clv_veml.readInt()) return false;						///	light is in band
+	}
+
+	AW_stru_t lv_AW = clv_veml.readAWcont();
+	bool lv_emit = changed(lv_AW, millis());
+	if (lv_emit) lp_AW = lv_AW;
+
+	///	gain & time is stable: sensor check band, else software check of next sample
+	if (clv_useInt && clv_sent && (clv_veml.steps() == 0)) {
+		if (lv_emit || !clv_armed) clf_arm();
+		else clv_veml.readInt();			///	band is the same, clear flag of this change
+		clv_next = millis() + cl_VEML7700::readyMs(clv_veml.readGainTime().idxTime1);
+	}
+	else if (clv_armed) {
+		clv_veml.disableInt();
+		clv_armed = false;
+	}
+	return lv_emit;
+}
+
+//============================================================================================
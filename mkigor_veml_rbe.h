@@ -0,0 +1,91 @@
+/**
+ * @brief	Report by exception for sensor light VEML7700: emit sample only if lux is changed.
+ * @author	Igor Mkprog, mkprogigor@gmail.com
+ * @details	Sample is emitted if ALS lux moved from the last emitted one by absolute delta (lux)
+ * 			or relative delta (%), or heartbeat interval is over. The first sample is always emitted.
+ * 			When gain & time is stable, band last +- delta is written to thresholds ALS_WL, ALS_WH,
+ * 			so sensor check it by itself: sample() read only ALS_INT (one i2c transaction per
+ * 			conversion), full measurement is done only if flag is set or heartbeat is due.
+ * 			Band is found in raw counts by the same integer lux (corrected, if setCorrection())
+ * 			as software check after measurement, so both check the same band to one count
+ * 			(float corrected lux can differ by 1 lux, see countsToLuxCorr()).
+ * 			Filter of ALS lux (setFilterEMA(), setFilterKalman()) switch thresholds off:
+ * 			filtered lux can move while raw count stay in band.
+ * 			Sensor should be used only by this object, because thresholds & ALS_INT_EN are its own.
+ * 			Without sensor (samples of cl_VEMLqueue) use changed(), it is only software check.
+ * @example
+ * 			cl_VEMLrbe rbe(veml);
+ * 			rbe.setDelta(5, 10);		rbe.setHeartbeat(600000);
+ * 			...	in loop: AW_stru_t aw;	if (rbe.sample(aw)) radioSend(aw.als1);
+ */
+
+#include <mkigor_veml.h>
+
+#ifndef mkigor_veml_rbe_h
+#define mkigor_veml_rbe_h
+
+//============================================================================================
+
+class cl_VEMLrbe {
+private:
+	cl_VEML7700		&clv_veml;
+	uint32_t		clv_absLux = 0;			///	absolute delta, lux, 0 - off
+	uint8_t			clv_relPct = 10;		///	relative delta, %, 0 - off
+	uint32_t		clv_heartbeatMs = 0;	///	max time between emitted samples, 0 - off
+	bool			clv_useInt = true;		///	offload check to thresholds of sensor
+	bool			clv_sent = false;		///	there is emitted sample
+	AW_stru_t		clv_lastAW = { 0, 0 };	///	the last emitted sample
+	uint32_t		clv_lastMs = 0;			///	millis() of the last emitted sample
+	bool			clv_armed = false;		///	band of the last sample is in thresholds of sensor
+	uint32_t		clv_next = 0;			///	millis() of next fresh conversion
+
+	uint32_t clf_delta(uint32_t lp_lux);
+	uint32_t clf_count(uint32_t lp_lux, GTidx_stru_t lp_gt, bool lp_corr);
+	void clf_arm();
+
+public:
+	/// sensor must be init by check() before
+	cl_VEMLrbe(cl_VEML7700 &lp_veml) : clv_veml(lp_veml) {};
+
+/**
+ * @brief set change of lux to emit sample, the smallest of both is used, 0 - off
+ * @param lp_absLux - absolute delta, lux, lp_relPct - relative delta, % of the last emitted lux
+ */
+void setDelta(uint32_t lp_absLux, uint8_t lp_relPct) { clv_absLux = lp_absLux; clv_relPct = lp_relPct; clv_armed = false; };
+
+/**
+ * @brief set max time between emitted samples, 0 - off (default)
+ */
+void setHeartbeat(uint32_t lp_ms) { clv_heartbeatMs = lp_ms; };
+
+/**
+ * @brief switch on (default) / off check by thresholds of sensor
+ */
+void useThresholds(bool lp_on);
+
+/**
+ * @brief software check of sample, sample is the last emitted one if it is emitted
+ * @param lp_AW - sample, lp_ms - millis() of sample
+ * @return true if sample should be emitted
+ */
+bool changed(const AW_stru_t &lp_AW, uint32_t lp_ms);
+
+/**
+ * @brief one cycle of report by exception, call it in loop
+ * @details	if band is in thresholds and heartbeat is not due, fn read ALS_INT once per conversion
+ * 			and return at once. Else it measure by readAWcont() (delay for fresh conversion)
+ * 			and check sample. Thresholds are armed again, if gain & time was not changed.
+ * @param lp_AW - emitted sample is written here
+ * @return true if sample is emitted
+ */
+bool sample(AW_stru_t &lp_AW);
+
+/// the last emitted sample
+AW_stru_t last() { return clv_lastAW; };
+
+/// forget the last emitted sample, the next one is emitted anyway
+void reset() { clv_sent = false; };
+};
+
+#endif
+//============================================================================================